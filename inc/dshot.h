@@ -18,87 +18,161 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "stm32f4xx.h"
+#include "dshot_proto.h"
+#include "dshot_filter.h"
 
 /* DShot Configuration */
-#define DSHOT_SPEED             600     /* DShot600 (can be 150, 300, 600, 1200) */
-
-/* Hardware Configuration - ADJUST FOR YOUR BOARD */
-#define DSHOT_TIMER             TIM1
-#define DSHOT_TIMER_RCC         RCC_APB2ENR_TIM1EN
-#define DSHOT_TIMER_CHANNEL     1       /* Timer channel (1-4) */
-#define DSHOT_GPIO_PORT         GPIOA
-#define DSHOT_GPIO_PIN          8       /* PA8 for TIM1_CH1 */
-#define DSHOT_GPIO_AF           1       /* Alternate function for TIM1 */
-#define DSHOT_DMA               DMA2
-#define DSHOT_DMA_STREAM        DMA2_Stream1
-#define DSHOT_DMA_CHANNEL       6       /* DMA channel for TIM1_CH1 */
-
-/* Input capture DMA (for receiving telemetry) */
-#define DSHOT_IC_DMA_STREAM     DMA2_Stream6
-#define DSHOT_IC_DMA_CHANNEL    0       /* DMA channel for TIM1_CH1 input capture */
-
-/* DShot Protocol Constants */
-#define DSHOT_FRAME_SIZE        16      /* Bits per frame */
-#define DSHOT_THROTTLE_MIN      48      /* Minimum throttle (0-47 reserved for commands) */
-#define DSHOT_THROTTLE_MAX      2047    /* Maximum throttle */
-#define DSHOT_CMD_MAX           47      /* Commands are 0-47 */
-
-/* Special DShot Commands */
-#define DSHOT_CMD_MOTOR_STOP    0
-#define DSHOT_CMD_BEEP1         1
-#define DSHOT_CMD_BEEP2         2
-#define DSHOT_CMD_BEEP3         3
-#define DSHOT_CMD_BEEP4         4
-#define DSHOT_CMD_BEEP5         5
-#define DSHOT_CMD_ESC_INFO      6
-#define DSHOT_CMD_SPIN_DIR_1    7
-#define DSHOT_CMD_SPIN_DIR_2    8
-#define DSHOT_CMD_3D_MODE_OFF   9
-#define DSHOT_CMD_3D_MODE_ON    10
-#define DSHOT_CMD_SETTINGS_REQ  11
-#define DSHOT_CMD_SAVE_SETTINGS 12
-#define DSHOT_CMD_EXTENDED_TELEM_ENABLE  13
-#define DSHOT_CMD_EXTENDED_TELEM_DISABLE 14
-
-/* Bidirectional DShot specific commands (must be sent 6x to take effect) */
-#define DSHOT_CMD_BIDIR_EDT_MODE_ON   13
-#define DSHOT_CMD_BIDIR_EDT_MODE_OFF  14
-
-/* Timing calculations for DShot600 at 168MHz timer clock */
+#define DSHOT_SPEED             600     /* Speed at dshot_init() (150, 300, 600, 1200); see dshot_set_speed() */
+
+/* Hardware Configuration - ADJUST FOR YOUR BOARD
+ * Each motor is described by a dshot_port_t entry in dshot_ports[]
+ * (src/dshot.c). All motors run through the same state machine.
+ */
+#define DSHOT_MAX_MOTORS        8       /* Upper bound on dshot_ports[] entries */
+#define DSHOT_MOTOR_COUNT       1       /* Entries in dshot_ports[] */
+
+/* Burst (multi-channel) output - TIM1 CH1-CH4 driven from one DMA stream
+ * Each timer update event triggers a 4-word DMA burst through TIMx->DMAR
+ * into CCR1..CCR4, so all four ESCs receive their frame in the same window.
+ * The pins and stream are described by dshot_burst_port (src/dshot.c).
+ */
+#define DSHOT_BURST_MOTORS      4       /* CH1-CH4 of one timer */
+
+/* Protocol constants, commands and telemetry types: dshot_proto.h */
+
+/* Timing calculations for DSHOT_SPEED at 168MHz timer clock (TIM1/TIM8 on APB2)
+ * The driver computes these at runtime in timer ticks for each port's
+ * timer clock and the current speed (dshot_set_speed()); the macros give
+ * the compile-time defaults for reference.
+ */
 #define TIMER_CLOCK_HZ          168000000UL
-#define DSHOT_BIT_TIME_US       (1000000UL / (DSHOT_SPEED * 1000UL))
-#define DSHOT_TIMER_PERIOD      ((TIMER_CLOCK_HZ * DSHOT_BIT_TIME_US) / 1000000UL)
-#define DSHOT_BIT_0_DUTY        (DSHOT_TIMER_PERIOD * 37 / 100)  /* 37.5% duty for '0' */
-#define DSHOT_BIT_1_DUTY        (DSHOT_TIMER_PERIOD * 75 / 100)  /* 75% duty for '1' */
+#define DSHOT_BIT_TIME_NS       (1000000UL / DSHOT_SPEED)                   /* 1666ns for DShot600 */
+#define DSHOT_TIMER_PERIOD      (TIMER_CLOCK_HZ / (DSHOT_SPEED * 1000UL))   /* 280 ticks for DShot600 */
+#define DSHOT_BIT_0_DUTY        (DSHOT_TIMER_PERIOD * 3 / 8)  /* 37.5% duty for '0' */
+#define DSHOT_BIT_1_DUTY        (DSHOT_TIMER_PERIOD * 3 / 4)  /* 75% duty for '1' */
 
 /* Bidirectional DShot timing
  * ESC responds at 5/4 the command rate
  * For DShot600 (600kbps command) → 750kbps response
  * Response bit time = 0.8 * command bit time
  */
-#define DSHOT_TELEM_BITRATE     (DSHOT_SPEED * 1000 * 5 / 4)     /* 750000 for DShot600 */
+#define DSHOT_TELEM_BITRATE     (DSHOT_SPEED * 1000UL * 5 / 4)   /* 750000 for DShot600 */
 #define DSHOT_TELEM_BIT_NS      (1000000000UL / DSHOT_TELEM_BITRATE)  /* ~1333ns per bit */
 
-/* GCR (Golay Run Length) encoding for bidirectional telemetry
- * 21 bits total: 20 GCR bits (4 nibbles × 5 bits) + 1 end marker
- * Decodes to 16 bits: 12-bit eRPM period + 4-bit CRC
- */
-#define DSHOT_TELEM_FRAME_BITS  21
-#define DSHOT_GCR_BITS          5       /* 5 GCR bits per nibble */
-#define DSHOT_TELEM_NIBBLES     4       /* 4 nibbles in response */
-
-/* Response timing window (in timer ticks at 168MHz)
- * Wait ~30μs after frame ends before ESC responds
+/* Response timing window
+ * ESC responds ~30μs after the frame ends
  * Response lasts ~28μs (21 bits at 750kbps)
+ * The pin switches to input DSHOT_TELEM_DELAY_US after the TX transfer
+ * completes and the capture closes DSHOT_TELEM_WINDOW_US later, both on
+ * compare events of DSHOT_RX_TIMER.
  */
 #define DSHOT_TELEM_DELAY_US    25
 #define DSHOT_TELEM_WINDOW_US   50
 
+/* Receive watchdog: dshot_update() ends a reception still waiting or
+ * capturing this long after its frame was sent (a lost window event),
+ * counting it as a timeout
+ */
+#define DSHOT_RX_WATCHDOG_US    1000
+
+/* Telemetry window timer - ADJUST FOR YOUR BOARD
+ * Free-running 32-bit APB1 timer (84MHz, no prescaler). Compare channel 1
+ * is shared by all motors and always set for the soonest pending receive
+ * window event, so any DSHOT_MOTOR_COUNT up to DSHOT_MAX_MOTORS works.
+ */
+#define DSHOT_RX_TIMER              TIM2
+#define DSHOT_RX_TIMER_RCC          RCC_APB1ENR_TIM2EN
+#define DSHOT_RX_TIMER_IRQn         TIM2_IRQn
+#define DSHOT_RX_TIMER_CLOCK_HZ     84000000UL
+#define DSHOT_RX_TIMER_IRQ_PRIORITY 1       /* Same as the DShot DMA interrupts */
+
+/* DShot DMA stream interrupts (TX, input capture, burst, bit-bang) */
+#define DSHOT_DMA_IRQ_PRIORITY      1
+
+/* The receive path must never preempt itself: the telemetry working
+ * copies and the capture log (dshot_capture_record()) have a single
+ * writer only because the window timer and every DMA interrupt that can
+ * end a capture run at the same priority.
+ */
+#if DSHOT_RX_TIMER_IRQ_PRIORITY != DSHOT_DMA_IRQ_PRIORITY
+#error "DSHOT_RX_TIMER_IRQ_PRIORITY must equal DSHOT_DMA_IRQ_PRIORITY"
+#endif
+
+/* Telemetry time base: DWT->CYCCNT at the core clock. Timestamps wrap
+ * every 2^32 cycles (25.5s at 168MHz); ages and latencies are only
+ * meaningful below that.
+ */
+#define DSHOT_TIME_CLOCK_HZ         168000000UL
+#define DSHOT_TIME_TICKS_PER_US     (DSHOT_TIME_CLOCK_HZ / 1000000UL)
+#define DSHOT_RX_TICKS_PER_US       (DSHOT_RX_TIMER_CLOCK_HZ / 1000000UL)
+
 /* Input capture buffer size (enough for all edges in response) */
 #define DSHOT_IC_BUFFER_SIZE    32
 
-/* Motor pole count for RPM calculation */
-#define MOTOR_POLES             14
+/* Telemetry decode context
+ * 1: decode and publish in the interrupt that ends the capture, so the
+ *    result is available as soon as the response window closes
+ * 0: defer decoding to the next dshot_update() call (PROCESSING state)
+ */
+#ifndef DSHOT_DECODE_IN_ISR
+#define DSHOT_DECODE_IN_ISR     1
+#endif
+
+#if DSHOT_MOTOR_COUNT > DSHOT_MAX_MOTORS
+#error "DSHOT_MOTOR_COUNT exceeds DSHOT_MAX_MOTORS"
+#endif
+
+/**
+ * @brief Hardware description of one DShot motor output
+ *
+ * The timer channel must support both output compare (sending) and
+ * input capture (receiving telemetry) on the same pin. The TX and IC
+ * streams must both be mapped to the TIMx_CHy DMA request; they may be
+ * the same stream, in which case it is reprogrammed on every direction
+ * change.
+ */
+typedef struct {
+    TIM_TypeDef        *timer;          /* Timer peripheral (TIM1, TIM8, TIM3, ...) */
+    uint32_t            timer_clock_hz; /* Timer kernel clock */
+    uint8_t             channel;        /* Timer channel (1-4) */
+    GPIO_TypeDef       *gpio;           /* GPIO port of the signal pin */
+    uint8_t             pin;            /* Pin number (0-15) */
+    uint8_t             af;             /* Alternate function for the timer */
+    DMA_TypeDef        *dma;            /* DMA controller serving the streams below */
+    DMA_Stream_TypeDef *tx_stream;      /* Stream for frame transmission */
+    uint8_t             tx_stream_index;/* Stream number (0-7) for flag registers */
+    uint8_t             tx_dma_channel; /* Request channel for TIMx_CHy */
+    IRQn_Type           tx_irq;
+    DMA_Stream_TypeDef *ic_stream;      /* Stream for telemetry input capture */
+    uint8_t             ic_stream_index;
+    uint8_t             ic_dma_channel;
+    IRQn_Type           ic_irq;
+    uint32_t            rcc_ahb1enr;    /* GPIO and DMA clock enable bits */
+    uint32_t            rcc_apb1enr;    /* Timer clock enable bits (APB1 timers) */
+    uint32_t            rcc_apb2enr;    /* Timer clock enable bits (APB2 timers) */
+} dshot_port_t;
+
+/**
+ * @brief Hardware description of the burst output group
+ *
+ * The stream must be mapped to the TIMx_UP DMA request.
+ */
+typedef struct {
+    TIM_TypeDef        *timer;
+    uint32_t            timer_clock_hz;
+    GPIO_TypeDef       *gpio;
+    uint8_t             pins[DSHOT_BURST_MOTORS];   /* Pins for CH1..CH4 */
+    uint8_t             af;
+    DMA_TypeDef        *dma;
+    DMA_Stream_TypeDef *stream;
+    uint8_t             stream_index;
+    uint8_t             dma_channel;
+    IRQn_Type           irq;
+    uint32_t            rcc_ahb1enr;
+    uint32_t            rcc_apb1enr;
+    uint32_t            rcc_apb2enr;
+} dshot_burst_port_t;
 
 /**
  * @brief DShot state machine states
@@ -112,67 +186,324 @@ typedef enum {
 } dshot_state_t;
 
 /**
- * @brief Bidirectional telemetry data
+ * @brief Result of a non-blocking send
+ *
+ * No send function waits on hardware. Each one is straight-line register
+ * code plus, for throttle/command sends, one fixed 16-bit encode loop:
+ * a few hundred CPU cycles (under 2us at 168MHz) whatever the DMA state.
+ */
+typedef enum {
+    DSHOT_SEND_QUEUED,          /* Frame armed, DMA transfer started */
+    DSHOT_SEND_BUSY,            /* Previous frame/telemetry still in progress; frame kept prepared */
+    DSHOT_SEND_DROPPED          /* Invalid argument or nothing prepared; nothing will be sent */
+} dshot_send_status_t;
+
+/**
+ * @brief Telemetry decode cost in CPU cycles (DWT cycle counter)
+ *
+ * One sample covers stopping the capture, decoding, publishing and
+ * switching the pin back to output, i.e. the interrupt time added per
+ * response with DSHOT_DECODE_IN_ISR.
  */
 typedef struct {
-    uint32_t erpm;              /* Electrical RPM */
-    uint32_t rpm;               /* Actual RPM (accounting for motor poles) */
-    uint16_t period_us;         /* Period in microseconds (raw from ESC) */
-    bool     valid;             /* Data validity flag */
-    uint32_t last_update;       /* Timestamp of last valid packet */
-    uint32_t frame_count;       /* Total frames sent */
-    uint32_t success_count;     /* Successful telemetry receptions */
-    uint32_t error_count;       /* CRC or decode errors */
-} dshot_telemetry_t;
-
-/**
- * @brief Initialize bidirectional DShot protocol
+    uint32_t count;             /* Decodes measured */
+    uint32_t last_cycles;
+    uint32_t max_cycles;
+    uint32_t avg_cycles;        /* Mean over count */
+} dshot_decode_stats_t;
+
+/**
+ * @brief Initialize bidirectional DShot protocol on every motor in dshot_ports[]
  * @return true if successful, false otherwise
  */
 bool dshot_init(void);
 
 /**
- * @brief Send throttle command to ESC with telemetry request
+ * @brief Change the DShot protocol speed at runtime
+ *
+ * Recomputes the bit period (ARR), '0'/'1' duty values and telemetry bit
+ * period in timer ticks for every port from its timer clock, and reloads
+ * the timers. Stop the frame scheduler before calling.
+ *
+ * @param speed_kbit 150, 300, 600 or 1200
+ * @return true if applied, false for an unsupported speed or if a motor
+ *         or the burst group is busy
+ */
+bool dshot_set_speed(uint16_t speed_kbit);
+
+/**
+ * @brief Get the current DShot protocol speed
+ * @return Speed in kbit/s (150, 300, 600 or 1200)
+ */
+uint16_t dshot_get_speed(void);
+
+/**
+ * @brief Send throttle command to one ESC with telemetry request
+ *
+ * Equivalent to dshot_motor_prepare_throttle() + dshot_motor_send_prepared().
+ * If the motor is busy the frame stays prepared for the next send.
+ *
+ * @param motor Motor index into dshot_ports[]
+ * @param throttle Throttle value (48-2047, or 0-47 for special commands)
+ * @return Send status
+ */
+dshot_send_status_t dshot_motor_send_throttle(uint8_t motor, uint16_t throttle);
+
+/**
+ * @brief Send special DShot command to one ESC
+ *
+ * Sends a single frame. Commands that must be repeated should go through
+ * dshot_scheduler_send_command().
+ *
+ * @param motor Motor index into dshot_ports[]
+ * @param command Command value (0-47)
+ * @return Send status
+ */
+dshot_send_status_t dshot_motor_send_command(uint8_t motor, uint8_t command);
+
+/**
+ * @brief Encode a throttle frame ahead of time
+ *
+ * The frame (with telemetry request) is encoded into the motor's back
+ * buffer and may be prepared while the previous frame is still on the
+ * wire or telemetry is being received. A later prepare replaces it.
+ *
+ * @param motor Motor index into dshot_ports[]
  * @param throttle Throttle value (48-2047, or 0-47 for special commands)
  */
-void dshot_send_throttle(uint16_t throttle);
+void dshot_motor_prepare_throttle(uint8_t motor, uint16_t throttle);
 
 /**
- * @brief Send special DShot command
+ * @brief Encode a special command frame ahead of time
+ * @param motor Motor index into dshot_ports[]
  * @param command Command value (0-47)
  */
-void dshot_send_command(uint8_t command);
+void dshot_motor_prepare_command(uint8_t motor, uint8_t command);
+
+/**
+ * @brief Send the most recently prepared frame
+ *
+ * Flips to the back buffer and arms DMA; no encoding is done here. The
+ * TX stream is only reprogrammed once its transfer-complete interrupt
+ * has confirmed that it is disabled, so this never polls the EN bit.
+ *
+ * @param motor Motor index into dshot_ports[]
+ * @return DSHOT_SEND_QUEUED if started, DSHOT_SEND_BUSY if the motor or
+ *         its stream is busy, DSHOT_SEND_DROPPED if no frame is prepared
+ */
+dshot_send_status_t dshot_motor_send_prepared(uint8_t motor);
 
 /**
- * @brief Check if DShot is ready to send next frame
+ * @brief Check if a motor is ready to send its next frame
+ * @param motor Motor index into dshot_ports[]
+ * @return true if ready
+ */
+bool dshot_motor_ready(uint8_t motor);
+
+/**
+ * @brief Get the state of one motor
+ * @param motor Motor index into dshot_ports[]
+ * @return Current state (DSHOT_STATE_IDLE for an invalid index)
+ */
+dshot_state_t dshot_motor_get_state(uint8_t motor);
+
+/**
+ * @brief Get telemetry data of one motor
+ *
+ * This is the decoder's working copy and may change field by field while
+ * it is read; use dshot_motor_read_telemetry() for a consistent record.
+ *
+ * @param motor Motor index into dshot_ports[]
+ * @return Pointer to telemetry structure, NULL for an invalid index
+ */
+dshot_telemetry_t* dshot_motor_get_telemetry(uint8_t motor);
+
+/**
+ * @brief Configure the eRPM filter of every motor
+ *
+ * Takes effect on the next frame; filter state is kept, and stages added
+ * by a higher order start from the current output. rate_hz is the rate
+ * telemetry arrives at, i.e. the scheduler frame rate.
+ *
+ * @param order 0 (median only), 1 (PT1) or 2 (PT2)
+ * @param cutoff_hz Low-pass cutoff
+ * @param rate_hz Telemetry frames per second per motor
+ * @return false if the parameters are rejected (previous setting kept)
+ */
+bool dshot_set_erpm_filter(uint8_t order, uint16_t cutoff_hz, uint16_t rate_hz);
+
+/**
+ * @brief Current eRPM filter coefficients (shared with the bit-bang port)
+ * @return Filter configuration
+ */
+const dshot_erpm_filter_config_t* dshot_get_erpm_filter(void);
+
+/**
+ * @brief Current time in telemetry time base counts
+ *
+ * Same clock as the timestamps in dshot_telemetry_t, so a control loop
+ * can stamp its own samples and align them with eRPM.
+ *
+ * @return DWT cycle counter
+ */
+uint32_t dshot_time_now(void);
+
+/**
+ * @brief Age of the last valid telemetry sample
+ * @param telem Telemetry record (e.g. a dshot_motor_read_telemetry() snapshot)
+ * @return Microseconds since it was decoded, UINT32_MAX if none was received
+ */
+uint32_t dshot_telem_age_us(const dshot_telemetry_t *telem);
+
+/**
+ * @brief Command to telemetry latency of the latest reception
+ * @param telem Telemetry record
+ * @return Microseconds from frame start to decoded response
+ */
+uint32_t dshot_telem_latency_us(const dshot_telemetry_t *telem);
+
+/**
+ * @brief Copy a consistent telemetry record of one motor
+ *
+ * Lock-free and never waits on the decoder: every reception is published
+ * to two copies under a sequence counter, and the reader takes the copy
+ * that is not being written, retrying only if a publish completed during
+ * the copy. Safe from any interrupt priority, interrupts stay enabled.
+ *
+ * Keep *out between calls (zero it once): the return value compares the
+ * new record with the previous contents, replacing the test-and-clear of
+ * dshot_motor_telemetry_available().
+ *
+ * @param motor Motor index into dshot_ports[]
+ * @param out Destination, holding the previous snapshot
+ * @return true if out now holds a valid reception newer than before
+ */
+bool dshot_motor_read_telemetry(uint8_t motor, dshot_telemetry_t *out);
+
+/**
+ * @brief Check if new telemetry is available for one motor since last check
+ * @param motor Motor index into dshot_ports[]
+ * @return true if new data available (false for an invalid index)
+ */
+bool dshot_motor_telemetry_available(uint8_t motor);
+
+/**
+ * @brief Send throttle command to motor 0 with telemetry request
+ * @param throttle Throttle value (48-2047, or 0-47 for special commands)
+ * @return Send status
+ */
+dshot_send_status_t dshot_send_throttle(uint16_t throttle);
+
+/**
+ * @brief Send special DShot command to motor 0
+ * @param command Command value (0-47)
+ * @return Send status
+ */
+dshot_send_status_t dshot_send_command(uint8_t command);
+
+/**
+ * @brief Check if motor 0 is ready to send next frame
  * @return true if ready
  */
 bool dshot_ready(void);
 
 /**
- * @brief Get current DShot state
+ * @brief Get current state of motor 0
  * @return Current state
  */
 dshot_state_t dshot_get_state(void);
 
 /**
- * @brief Get telemetry data
+ * @brief Get telemetry data of motor 0
  * @return Pointer to telemetry structure
  */
 dshot_telemetry_t* dshot_get_telemetry(void);
 
 /**
- * @brief Check if new telemetry is available since last check
+ * @brief Check if new telemetry is available for motor 0 since last check
  * @return true if new data available
  */
 bool dshot_telemetry_available(void);
 
+/**
+ * @brief Initialize burst output on CH1-CH4 of the burst timer
+ *
+ * Reconfigures the timer described by dshot_burst_port for four-channel
+ * output driven by a single DMA stream through the DCR/DMAR burst
+ * interface. Motors in dshot_ports[] on the same timer are stopped and
+ * stay unusable until dshot_init() is called again.
+ * Burst frames are output-only; no telemetry is captured.
+ *
+ * @return true if successful, false otherwise
+ */
+bool dshot_burst_init(void);
+
+/**
+ * @brief Send one frame to each of the burst motors in a single transfer
+ * @param throttles Throttle values (48-2047, or 0-47 for special commands),
+ *                  one per channel in CH1..CH4 order
+ * @return DSHOT_SEND_QUEUED if started, DSHOT_SEND_BUSY if the previous
+ *         burst is still on the wire, DSHOT_SEND_DROPPED if burst output
+ *         is not initialized
+ */
+dshot_send_status_t dshot_burst_send(const uint16_t throttles[DSHOT_BURST_MOTORS]);
+
+/**
+ * @brief Check if the previous burst transfer has completed
+ * @return true if ready
+ */
+bool dshot_burst_ready(void);
+
 /**
  * @brief Process bidirectional telemetry (call from main loop)
  *
- * This handles the state machine for receiving and decoding
- * the ESC's telemetry response.
+ * The receive window itself (switch to input, capture, timeout) runs on
+ * DSHOT_RX_TIMER compare interrupts. With DSHOT_DECODE_IN_ISR the
+ * response is also decoded there; otherwise this decodes captures
+ * waiting in PROCESSING. It also ends receptions older than
+ * DSHOT_RX_WATCHDOG_US, so call it regularly either way.
  */
 void dshot_update(void);
 
+/**
+ * @brief Read telemetry decode cycle statistics (all motors)
+ * @param stats Destination
+ */
+void dshot_get_decode_stats(dshot_decode_stats_t *stats);
+
+/**
+ * @brief Reset telemetry decode cycle statistics
+ */
+void dshot_reset_decode_stats(void);
+
+/**
+ * @brief Clear all interrupt flags (TC, HT, TE, DME, FE) of a DMA stream
+ * @param dma DMA controller
+ * @param stream_index Stream number (0-7)
+ */
+void dshot_dma_clear_flags(DMA_TypeDef *dma, uint8_t stream_index);
+
+/**
+ * @brief DMA stream interrupt dispatcher
+ *
+ * Call from the DMAx_Streamy_IRQHandler of every stream referenced by
+ * dshot_ports[], dshot_burst_port or dshot_bb_port. Handlers for the
+ * default board configuration are provided in dshot.c.
+ *
+ * @param stream Stream that raised the interrupt
+ */
+void dshot_dma_irq_handler(DMA_Stream_TypeDef *stream);
+
+/**
+ * @brief Receive window timer interrupt handler
+ *
+ * Call from the IRQ handler of DSHOT_RX_TIMER (TIM2_IRQHandler is
+ * provided in dshot.c).
+ */
+void dshot_rx_timer_irq_handler(void);
+
+/* Board description tables (src/dshot.c) */
+extern const dshot_port_t dshot_ports[DSHOT_MOTOR_COUNT];
+extern const dshot_burst_port_t dshot_burst_port;
+
 #endif /* DSHOT_H */
@@ -0,0 +1,125 @@
+/**
+ * @file dshot_bitbang.h
+ * @brief GPIO bit-banged DShot output via DMA to BSRR
+ *
+ * Alternative TX engine for boards whose motor pins do not sit on timer
+ * channels with a free DMA request. Any pins on one GPIO port are driven
+ * simultaneously: a timer update DMA request streams a precomputed table
+ * of BSRR words to the port, three words per DShot bit.
+ *
+ * Bit timing (inverted / bidirectional DShot, idle high):
+ *   slot 0 (t = 0):     all pins low
+ *   slot 1 (t = 1/3):   pins sending '0' go high  -> 33% low
+ *   slot 2 (t = 2/3):   pins sending '1' go high  -> 67% low
+ * which is within ESC tolerance of the nominal 37.5% / 75%.
+ *
+ * Bidirectional telemetry is received without input capture: after the
+ * frame the pins switch to input and the same timer/stream sample the
+ * port's IDR at about 3x the telemetry bitrate (again through DMA2, the
+ * only controller that reaches GPIO). One capture holds the
+ * responses of all motors on the port; a run-length decoder turns each
+ * pin's samples into its 21-bit response.
+ */
+
+#ifndef DSHOT_BITBANG_H
+#define DSHOT_BITBANG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f4xx.h"
+#include "dshot.h"
+
+#define DSHOT_BB_MAX_MOTORS     8       /* Pins per bit-bang port */
+#define DSHOT_BB_SLOTS_PER_BIT  3       /* BSRR writes per DShot bit */
+#define DSHOT_BB_OVERSAMPLE     3       /* IDR samples per telemetry bit */
+#define DSHOT_BB_MAX_SAMPLES    384     /* Covers delay + window at DShot1200 */
+
+/**
+ * @brief Hardware description of a bit-bang port
+ *
+ * The stream must be mapped to the TIMx_UP DMA request of the timer, and
+ * dma must be DMA2: the peripheral port of DMA1 only reaches APB1, not
+ * the GPIO registers on AHB1. That limits the slot timer to TIM1 or TIM8
+ * (the timers whose update request is on DMA2).
+ */
+typedef struct {
+    GPIO_TypeDef       *gpio;                           /* Port driving all pins */
+    uint8_t             pins[DSHOT_BB_MAX_MOTORS];      /* Pin per motor */
+    uint8_t             motor_count;                    /* Used entries in pins[] */
+    TIM_TypeDef        *timer;                          /* Slot timer */
+    uint32_t            timer_clock_hz;
+    DMA_TypeDef        *dma;
+    DMA_Stream_TypeDef *stream;
+    uint8_t             stream_index;
+    uint8_t             dma_channel;
+    IRQn_Type           irq;
+    uint32_t            rcc_ahb1enr;
+    uint32_t            rcc_apb1enr;
+    uint32_t            rcc_apb2enr;
+} dshot_bb_port_t;
+
+/**
+ * @brief Initialize the bit-bang port
+ *
+ * Pins are configured as push-pull outputs idling high; the slot timer
+ * is set up for the current dshot_get_speed().
+ *
+ * @return true if successful, false if the port description is invalid
+ *         (no pins, too many pins, or a stream not on DMA2)
+ */
+bool dshot_bb_init(void);
+
+/**
+ * @brief Send one frame to every motor on the port in a single transfer
+ *
+ * With request_telemetry set, the port samples the responses for
+ * DSHOT_TELEM_DELAY_US + DSHOT_TELEM_WINDOW_US after the frame and stays
+ * busy until dshot_bb_update() has decoded them.
+ *
+ * @param values Throttle (48-2047) or command (0-47) per motor, in pins[] order
+ * @param request_telemetry Telemetry request flag for all frames
+ * @return DSHOT_SEND_QUEUED if started, DSHOT_SEND_BUSY if the port is
+ *         still sending or sampling, DSHOT_SEND_DROPPED if not initialized
+ */
+dshot_send_status_t dshot_bb_send(const uint16_t *values, bool request_telemetry);
+
+/**
+ * @brief Check if the port is ready for the next frame
+ * @return true if ready
+ */
+bool dshot_bb_ready(void);
+
+/**
+ * @brief Decode captured telemetry (call from main loop)
+ */
+void dshot_bb_update(void);
+
+/**
+ * @brief Get telemetry data of one bit-bang motor
+ * @param motor Index into dshot_bb_port.pins[]
+ * @return Pointer to telemetry structure, NULL for an invalid index
+ */
+dshot_telemetry_t* dshot_bb_get_telemetry(uint8_t motor);
+
+/**
+ * @brief Check if new telemetry is available for one bit-bang motor
+ * @param motor Index into dshot_bb_port.pins[]
+ * @return true if new data available (false for an invalid index)
+ */
+bool dshot_bb_telemetry_available(uint8_t motor);
+
+/**
+ * @brief Bit-bang stream interrupt
+ *
+ * Called by dshot_dma_irq_handler() for every stream, so the IRQ handler
+ * of the port's stream only has to call that dispatcher.
+ *
+ * @param stream Stream that raised the interrupt
+ * @return true if it was the bit-bang stream of an initialized port
+ */
+bool dshot_bb_dma_irq_handler(DMA_Stream_TypeDef *stream);
+
+/* Board description (src/dshot_bitbang.c) */
+extern const dshot_bb_port_t dshot_bb_port;
+
+#endif /* DSHOT_BITBANG_H */
@@ -0,0 +1,111 @@
+/**
+ * @file dshot_capture.h
+ * @brief Raw telemetry capture log for offline decoder analysis
+ *
+ * Keeps the last DSHOT_CAPTURE_LOG_SIZE input captures (edge timestamps,
+ * edge count, decode result) in a ring, either failed receptions only or
+ * every Nth reception. dshot_capture_dump() writes the ring in a compact
+ * binary form through a byte output function (e.g. uart_putc); the host
+ * tool tools/dshot_replay.c reads such dumps and runs them through the
+ * same decoder (make replay).
+ *
+ * Dump format (little-endian):
+ *   'D' 'S' 'C' '1'  count:u8
+ *   count records, oldest first:
+ *     motor:u8 result:u8 edge_count:u8 bit_period:u16 rx_scale:u32 seq:u32
+ *     edges:u16[edge_count] check:u8
+ * check is the XOR of all record bytes before it. rx_scale is the clock
+ * estimate the capture was decoded with, result a dshot_telem_result_t.
+ *
+ * This header has no hardware dependencies so host tools can include it.
+ */
+
+#ifndef DSHOT_CAPTURE_H
+#define DSHOT_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dshot_proto.h"
+
+#ifndef DSHOT_CAPTURE_LOG
+#define DSHOT_CAPTURE_LOG           1       /* Record captures from the receive path */
+#endif
+#define DSHOT_CAPTURE_LOG_SIZE      16      /* Records kept (power of two, <= 255) */
+#define DSHOT_CAPTURE_MAX_EDGES     32      /* Edges per record (>= DSHOT_IC_BUFFER_SIZE) */
+
+#define DSHOT_CAPTURE_MAGIC         "DSC1"
+#define DSHOT_CAPTURE_MAGIC_LEN     4
+
+#if (DSHOT_CAPTURE_LOG_SIZE & (DSHOT_CAPTURE_LOG_SIZE - 1)) != 0 || DSHOT_CAPTURE_LOG_SIZE > 255
+#error "DSHOT_CAPTURE_LOG_SIZE must be a power of two no larger than 255"
+#endif
+
+/**
+ * @brief Which receptions are kept
+ */
+typedef enum {
+    DSHOT_CAPTURE_OFF,
+    DSHOT_CAPTURE_FAILED,       /* Only receptions that did not decode */
+    DSHOT_CAPTURE_SAMPLED       /* Every Nth reception, whatever the result */
+} dshot_capture_mode_t;
+
+/**
+ * @brief One logged capture
+ */
+typedef struct {
+    uint32_t seq;               /* Reception number (all receptions, all motors) */
+    uint32_t rx_scale;          /* Clock estimate used for the decode, 16.16 */
+    uint16_t bit_period;        /* Nominal telemetry bit period, timer ticks */
+    uint8_t  motor;
+    uint8_t  result;            /* dshot_telem_result_t */
+    uint8_t  edge_count;
+    uint16_t edges[DSHOT_CAPTURE_MAX_EDGES];
+} dshot_capture_record_t;
+
+/**
+ * @brief Select which receptions are logged
+ * @param mode Logging mode
+ * @param sample_every N for DSHOT_CAPTURE_SAMPLED (0 is treated as 1)
+ */
+void dshot_capture_set_mode(dshot_capture_mode_t mode, uint16_t sample_every);
+
+/**
+ * @brief Offer one finished capture to the log (call from the receive path)
+ *
+ * Constant time: at most one copy of edge_count timestamps. Ignored while
+ * a dump is in progress.
+ *
+ * Not reentrant: the sequence counter and ring head are updated without
+ * locking, so all calls must come from one priority level. dshot.c calls
+ * it from the decode, i.e. from the window timer and capture DMA
+ * interrupts (DSHOT_DECODE_IN_ISR, priorities tied together by a check in
+ * dshot.h) or from dshot_update() otherwise; its receive watchdog calls
+ * it with interrupts disabled.
+ *
+ * @param motor Motor index
+ * @param edges Captured timer values
+ * @param edge_count Number of captured values
+ * @param bit_period Nominal telemetry bit period in timer ticks
+ * @param rx_scale Clock estimate used for the decode (16.16)
+ * @param result Decode result
+ */
+void dshot_capture_record(uint8_t motor, const uint16_t *edges, uint8_t edge_count,
+                          uint16_t bit_period, uint32_t rx_scale, dshot_telem_result_t result);
+
+/**
+ * @brief Number of records currently held
+ * @return Records in the ring
+ */
+uint8_t dshot_capture_count(void);
+
+/**
+ * @brief Write the log in the binary dump format and clear it
+ *
+ * Logging is paused while the dump runs. Call from the main loop.
+ *
+ * @param put Byte output function
+ * @return Records written
+ */
+uint8_t dshot_capture_dump(void (*put)(char c));
+
+#endif /* DSHOT_CAPTURE_H */
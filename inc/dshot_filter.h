@@ -0,0 +1,163 @@
+/**
+ * @file dshot_filter.h
+ * @brief Streaming eRPM filter: median-of-3 spike rejection and PT1/PT2 low-pass
+ *
+ * Runs once per valid telemetry frame after decode. A median over the last
+ * three raw values removes single-frame outliers that pass the CRC, then
+ * one (PT1) or two (PT2) first-order low-pass stages smooth the result.
+ * Integer arithmetic only: one 32x32->64 multiply per stage, no division
+ * per sample, so it fits the decode interrupt at 8kHz x 8 motors.
+ *
+ * State is per motor (dshot_erpm_filter_t); the coefficients are shared
+ * (dshot_erpm_filter_config_t).
+ *
+ * dshot_erpm_motion_t differentiates the filtered eRPM over the sample
+ * timestamps into acceleration and jerk, incrementally from the previous
+ * sample (one hardware divide per sample).
+ *
+ * dshot_erpm_sample() runs both for one reception; the receivers call it
+ * after every decode so only eRPM frames reach the stages.
+ *
+ * This header has no hardware dependencies so host tools can include it.
+ */
+
+#ifndef DSHOT_FILTER_H
+#define DSHOT_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dshot_proto.h"
+
+/* Defaults applied by dshot_init() (change at runtime with dshot_set_erpm_filter()) */
+#ifndef DSHOT_ERPM_FILTER
+#define DSHOT_ERPM_FILTER               1       /* Filter eRPM in the receive path */
+#endif
+#define DSHOT_ERPM_FILTER_ORDER         2       /* 0 = median only, 1 = PT1, 2 = PT2 */
+#define DSHOT_ERPM_FILTER_CUTOFF_HZ     100     /* Low-pass design cutoff (-5dB for PT2 at 1kHz) */
+#define DSHOT_ERPM_FILTER_RATE_HZ       1000    /* Telemetry frames per second per motor (scheduler default) */
+
+#ifndef DSHOT_ERPM_MOTION
+#define DSHOT_ERPM_MOTION               0       /* Publish rpm_accel / rpm_jerk (opt-in) */
+#endif
+#define DSHOT_ERPM_MOTION_MAX_GAP_MS    100     /* Longer gaps between samples restart the estimate */
+
+#define DSHOT_ERPM_FILTER_MAX_ORDER     2
+#define DSHOT_ERPM_FILTER_FRAC          4       /* Stage state fraction bits (60e6 eRPM fits) */
+
+/**
+ * @brief Low-pass coefficients shared by all motors
+ */
+typedef struct {
+    uint32_t k;                 /* Per-stage gain dt / (RC + dt), Q16 */
+    uint8_t  order;             /* Low-pass stages after the median */
+} dshot_erpm_filter_config_t;
+
+/**
+ * @brief Filter state of one motor
+ */
+typedef struct {
+    uint32_t history[3];        /* Last raw values for the median */
+    uint8_t  samples;           /* Raw values seen, saturates at 3 */
+    uint8_t  order;             /* Stages run on the previous value */
+    int32_t  stage[DSHOT_ERPM_FILTER_MAX_ORDER];   /* Low-pass outputs, Q4 */
+} dshot_erpm_filter_t;
+
+/**
+ * @brief Acceleration and jerk estimate of one motor
+ */
+typedef struct {
+    uint32_t last_time;         /* Timestamp of the previous sample */
+    uint32_t last_erpm;
+    int32_t  accel;             /* eRPM/s */
+    int32_t  jerk;              /* eRPM/s^2 */
+    uint8_t  samples;           /* Samples since restart, saturates at 3 */
+} dshot_erpm_motion_t;
+
+/**
+ * @brief Compute low-pass coefficients
+ *
+ * Each stage is the RC low-pass with w = 2 * pi * cutoff_hz / rate_hz
+ * discretised as y += k * (x - y), k = w / (1 + w); for PT2 each stage is
+ * set to 1.554 x cutoff_hz so the analog cascade would be 3dB down at
+ * cutoff_hz. The discretisation attenuates more than the analog design
+ * as cutoff_hz approaches rate_hz / 2: the gain at cutoff_hz is 0.62 for
+ * PT1 and 0.56 for PT2 at rate_hz / 10 (-4.1 / -5.1 dB), 0.66 / 0.62 at
+ * rate_hz / 20. The median in front takes a few percent more near the
+ * cutoff; make bench measures the whole filter. Call outside the sample
+ * path (one division).
+ *
+ * @param config Destination
+ * @param order 0 (median only), 1 (PT1) or 2 (PT2)
+ * @param cutoff_hz Low-pass cutoff
+ * @param rate_hz Rate at which samples arrive
+ * @return false if order is out of range or cutoff_hz is not below rate_hz / 2
+ */
+bool dshot_erpm_filter_config(dshot_erpm_filter_config_t *config, uint8_t order,
+                              uint16_t cutoff_hz, uint16_t rate_hz);
+
+/**
+ * @brief Clear the filter state; the next sample restarts it
+ * @param filter Filter state
+ */
+void dshot_erpm_filter_reset(dshot_erpm_filter_t *filter);
+
+/**
+ * @brief Feed one raw eRPM value
+ *
+ * Until three values have been seen the median passes the newest value
+ * through; the first value also initialises the low-pass stages, so the
+ * output starts at the measured speed rather than ramping up from 0.
+ * Stages added by a higher config->order since the previous value are
+ * initialised from the stage before them in the same way.
+ *
+ * @param filter Filter state
+ * @param config Coefficients
+ * @param erpm Raw eRPM of a valid frame
+ * @return Filtered eRPM
+ */
+uint32_t dshot_erpm_filter_apply(dshot_erpm_filter_t *filter,
+                                 const dshot_erpm_filter_config_t *config, uint32_t erpm);
+
+/**
+ * @brief Clear the motion estimate; accel and jerk read 0 until refilled
+ * @param motion Motion state
+ */
+void dshot_erpm_motion_reset(dshot_erpm_motion_t *motion);
+
+/**
+ * @brief Feed one filtered eRPM sample
+ *
+ * accel is valid from the second sample, jerk from the third. A gap
+ * longer than DSHOT_ERPM_MOTION_MAX_GAP_MS (lost telemetry) restarts the
+ * estimate from this sample. Results saturate at the int32_t range.
+ *
+ * @param motion Motion state
+ * @param erpm Filtered eRPM
+ * @param time Sample timestamp, free-running 32-bit counter
+ * @param clock_hz Counter rate (at most 268MHz)
+ */
+void dshot_erpm_motion_update(dshot_erpm_motion_t *motion, uint32_t erpm,
+                              uint32_t time, uint32_t clock_hz);
+
+/**
+ * @brief Run one reception through the filter and motion stages
+ *
+ * Only an eRPM frame (DSHOT_TELEM_OK) is a new sample: it updates
+ * erpm_filtered and, with a motion state, rpm_accel and rpm_jerk. EDT
+ * frames and failures leave all three untouched, so repeated eRPM values
+ * never reach the filter or the derivative.
+ *
+ * @param telemetry Telemetry just decoded
+ * @param result Outcome of the reception
+ * @param filter Filter state, NULL to publish the raw eRPM
+ * @param config Filter coefficients
+ * @param motion Motion state, NULL to skip the estimate
+ * @param time Sample timestamp, free-running 32-bit counter
+ * @param clock_hz Counter rate
+ * @return true if the reception was a new eRPM sample
+ */
+bool dshot_erpm_sample(dshot_telemetry_t *telemetry, dshot_telem_result_t result,
+                       dshot_erpm_filter_t *filter, const dshot_erpm_filter_config_t *config,
+                       dshot_erpm_motion_t *motion, uint32_t time, uint32_t clock_hz);
+
+#endif /* DSHOT_FILTER_H */
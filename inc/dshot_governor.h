@@ -0,0 +1,89 @@
+/**
+ * @file dshot_governor.h
+ * @brief Fixed-point PI(D) RPM governor
+ *
+ * Turns an eRPM setpoint and the measured (filtered) eRPM into a DShot
+ * throttle, one update per fresh telemetry sample. Gains are in throttle
+ * units per eRPM, Q8.24, and per sample, so they hold for one telemetry
+ * rate (the scheduler frame rate).
+ *
+ * - P on the error, D on the measurement (no kick on setpoint steps)
+ * - Anti-windup: the integrator only moves when the output is not
+ *   saturated in the direction of the error, and stays within the
+ *   output range
+ * - Slew limit: the output moves at most slew throttle units per update
+ *
+ * The frame scheduler runs one governor per motor
+ * (dshot_scheduler_set_rpm()). This header has no hardware dependencies
+ * so host tools can include it.
+ */
+
+#ifndef DSHOT_GOVERNOR_H
+#define DSHOT_GOVERNOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DSHOT_GOVERNOR_GAIN_FRAC    24
+#define DSHOT_GOVERNOR_GAIN(x)      ((int32_t)((x) * (1L << DSHOT_GOVERNOR_GAIN_FRAC) + 0.5))
+
+/* Defaults for a small motor at 1kHz (about 50 eRPM per throttle unit, 50ms time constant) */
+#define DSHOT_GOVERNOR_KP           DSHOT_GOVERNOR_GAIN(0.005)
+#define DSHOT_GOVERNOR_KI           DSHOT_GOVERNOR_GAIN(0.0001)
+#define DSHOT_GOVERNOR_KD           0
+#define DSHOT_GOVERNOR_OUT_MIN      48      /* DSHOT_THROTTLE_MIN */
+#define DSHOT_GOVERNOR_OUT_MAX      2047    /* DSHOT_THROTTLE_MAX */
+#define DSHOT_GOVERNOR_SLEW         10      /* Throttle units per update */
+#define DSHOT_GOVERNOR_TIMEOUT_US   20000   /* Telemetry older than this: open loop */
+
+/**
+ * @brief Governor tuning, shared by all motors
+ */
+typedef struct {
+    int32_t  kp;                /* Throttle per eRPM of error, Q8.24 */
+    int32_t  ki;                /* Throttle per eRPM of error per sample, Q8.24 */
+    int32_t  kd;                /* Throttle per eRPM change per sample, Q8.24 */
+    uint16_t out_min;           /* Throttle range */
+    uint16_t out_max;
+    uint16_t slew;              /* Largest output step per update */
+} dshot_governor_config_t;
+
+/**
+ * @brief Governor state of one motor
+ */
+typedef struct {
+    uint32_t setpoint;          /* Target eRPM */
+    int64_t  integrator;        /* Throttle, Q.24 */
+    uint32_t prev_erpm;         /* Measurement of the previous update */
+    uint16_t output;            /* Throttle of the last update */
+    bool     primed;            /* prev_erpm is valid */
+} dshot_governor_t;
+
+/**
+ * @brief Fill a configuration with the DSHOT_GOVERNOR_* defaults
+ * @param config Destination
+ */
+void dshot_governor_config_default(dshot_governor_config_t *config);
+
+/**
+ * @brief Restart the governor from a throttle (bumpless transfer)
+ *
+ * The integrator is preloaded with throttle, so the first update starts
+ * from the open-loop value rather than from the bottom of the range.
+ *
+ * @param gov Governor state
+ * @param config Tuning (for the output range)
+ * @param throttle Throttle currently applied
+ */
+void dshot_governor_reset(dshot_governor_t *gov, const dshot_governor_config_t *config, uint16_t throttle);
+
+/**
+ * @brief Run one controller update
+ * @param gov Governor state (setpoint set by the caller)
+ * @param config Tuning
+ * @param erpm Measured eRPM of a fresh sample
+ * @return Throttle to send, within [out_min, out_max]
+ */
+uint16_t dshot_governor_update(dshot_governor_t *gov, const dshot_governor_config_t *config, uint32_t erpm);
+
+#endif /* DSHOT_GOVERNOR_H */
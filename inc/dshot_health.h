@@ -0,0 +1,116 @@
+/**
+ * @file dshot_health.h
+ * @brief Motor stall / desync detector comparing commanded throttle to measured eRPM
+ *
+ * Per motor, the commanded throttle is passed through a first-order lag
+ * standing in for the motor's spin-up time, and the eRPM per throttle
+ * unit is learned in DSHOT_HEALTH_BINS throttle bins while the motor runs
+ * steadily. Each fresh telemetry sample is then checked for:
+ *
+ * - Stall: lagged throttle above stall_throttle, eRPM below stall_erpm
+ * - Desync: eRPM more than band_pct below the learned band for the
+ *   lagged throttle
+ * - Collapse: eRPM more than collapse_pct below its recent average
+ *   while the throttle is not being reduced
+ *
+ * A condition must hold for confirm consecutive samples (a few ms at the
+ * scheduler rate) before its flag is set. Flags latch until cleared. After
+ * a start from idle, stall and desync checks wait grace samples for the
+ * ESC to spin up. Everything is O(1) per sample with one divide while
+ * learning.
+ *
+ * The frame scheduler runs one detector per motor and can cut the motor
+ * on a fault (dshot_scheduler_get_faults()). This header has no hardware
+ * dependencies so host tools can include it.
+ */
+
+#ifndef DSHOT_HEALTH_H
+#define DSHOT_HEALTH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef DSHOT_HEALTH
+#define DSHOT_HEALTH                1       /* Run the detector in the frame scheduler */
+#endif
+#define DSHOT_HEALTH_BINS           8       /* Learned bands over the throttle range */
+
+/* Defaults (change at runtime with dshot_scheduler_set_health()) */
+#define DSHOT_HEALTH_STALL_THROTTLE 200     /* Throttle above which the motor must turn */
+#define DSHOT_HEALTH_STALL_ERPM     1000    /* Slower than this counts as not turning */
+#define DSHOT_HEALTH_BAND_PCT       40      /* Allowed shortfall below the learned band */
+#define DSHOT_HEALTH_COLLAPSE_PCT   50      /* Drop below the recent average */
+#define DSHOT_HEALTH_CONFIRM        3       /* Consecutive samples to set a flag */
+#define DSHOT_HEALTH_LAG_SHIFT      5       /* Throttle lag, 2^n samples (32ms at 1kHz) */
+#define DSHOT_HEALTH_GRACE          300     /* Samples after a start before stall/desync checks */
+#define DSHOT_HEALTH_AUTO_CUT       false   /* Stop the motor on a fault */
+
+/* Fault flags */
+#define DSHOT_HEALTH_STALL          (1 << 0)
+#define DSHOT_HEALTH_DESYNC         (1 << 1)
+#define DSHOT_HEALTH_COLLAPSE       (1 << 2)
+
+/**
+ * @brief Detector tuning, shared by all motors
+ */
+typedef struct {
+    uint16_t stall_throttle;    /* DShot throttle value */
+    uint32_t stall_erpm;
+    uint8_t  band_pct;
+    uint8_t  collapse_pct;
+    uint8_t  confirm;
+    uint8_t  lag_shift;
+    uint16_t grace;             /* Samples */
+    bool     auto_cut;
+} dshot_health_config_t;
+
+/**
+ * @brief Detector state of one motor
+ */
+typedef struct {
+    int32_t  throttle_lag;      /* Lagged throttle above DSHOT_THROTTLE_MIN, Q8 */
+    uint32_t ratio[DSHOT_HEALTH_BINS];  /* Learned eRPM per throttle unit, Q8, 0 = not learned */
+    uint32_t average_erpm;      /* Recent eRPM for the collapse check */
+    uint16_t grace;             /* Samples left before stall/desync checks */
+    uint8_t  stall_count;       /* Consecutive samples per condition */
+    uint8_t  desync_count;
+    uint8_t  collapse_count;
+    uint8_t  faults;            /* Latched DSHOT_HEALTH_* flags */
+} dshot_health_t;
+
+/**
+ * @brief Fill a configuration with the DSHOT_HEALTH_* defaults
+ * @param config Destination
+ */
+void dshot_health_config_default(dshot_health_config_t *config);
+
+/**
+ * @brief Clear the state including the learned bands
+ * @param health Detector state
+ * @param config Tuning
+ */
+void dshot_health_reset(dshot_health_t *health, const dshot_health_config_t *config);
+
+/**
+ * @brief Clear latched faults, keeping the learned bands
+ * @param health Detector state
+ */
+void dshot_health_clear(dshot_health_t *health);
+
+/**
+ * @brief Advance the detector by one frame
+ *
+ * Call once per frame sent. Throttle values below DSHOT_THROTTLE_MIN
+ * (stop, commands) restart the lag and the grace period.
+ *
+ * @param health Detector state
+ * @param config Tuning
+ * @param throttle DShot value commanded this frame
+ * @param erpm Measured eRPM (raw)
+ * @param fresh erpm is a new valid sample
+ * @return Latched DSHOT_HEALTH_* flags
+ */
+uint8_t dshot_health_update(dshot_health_t *health, const dshot_health_config_t *config,
+                            uint16_t throttle, uint32_t erpm, bool fresh);
+
+#endif /* DSHOT_HEALTH_H */
@@ -0,0 +1,426 @@
+/**
+ * @file dshot_proto.h
+ * @brief DShot protocol core: frame encoding and telemetry decoding
+ *
+ * Pure logic shared by all output engines and receivers. This module has
+ * no hardware dependency (no stm32f4xx.h) so it also builds for the host
+ * (`make host`) for benchmarking and offline decoding of captures.
+ */
+
+#ifndef DSHOT_PROTO_H
+#define DSHOT_PROTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DShot Protocol Constants */
+#define DSHOT_FRAME_SIZE        16      /* Bits per frame */
+#define DSHOT_THROTTLE_MIN      48      /* Minimum throttle (0-47 reserved for commands) */
+#define DSHOT_THROTTLE_MAX      2047    /* Maximum throttle */
+#define DSHOT_CMD_MAX           47      /* Commands are 0-47 */
+
+/* Special DShot Commands */
+#define DSHOT_CMD_MOTOR_STOP    0
+#define DSHOT_CMD_BEEP1         1
+#define DSHOT_CMD_BEEP2         2
+#define DSHOT_CMD_BEEP3         3
+#define DSHOT_CMD_BEEP4         4
+#define DSHOT_CMD_BEEP5         5
+#define DSHOT_CMD_ESC_INFO      6
+#define DSHOT_CMD_SPIN_DIR_1    7
+#define DSHOT_CMD_SPIN_DIR_2    8
+#define DSHOT_CMD_3D_MODE_OFF   9
+#define DSHOT_CMD_3D_MODE_ON    10
+#define DSHOT_CMD_SETTINGS_REQ  11
+#define DSHOT_CMD_SAVE_SETTINGS 12
+#define DSHOT_CMD_EXTENDED_TELEM_ENABLE  13
+#define DSHOT_CMD_EXTENDED_TELEM_DISABLE 14
+
+/* Bidirectional DShot specific commands (must be sent 6x to take effect) */
+#define DSHOT_CMD_BIDIR_EDT_MODE_ON   13
+#define DSHOT_CMD_BIDIR_EDT_MODE_OFF  14
+
+/* GCR (Group Coded Recording) encoding for bidirectional telemetry
+ * On the wire: 21 bits, a start bit (line low) followed by the 20-bit
+ * GCR word transition-encoded (each GCR '1' toggles the line), so
+ * gcr = line ^ (line >> 1) with line low = 1.
+ * GCR decodes to 16 bits: 12-bit value + 4-bit inverted CRC.
+ * The value is a period in microseconds as eee mmmmmmmmm:
+ * period_us = mantissa << exponent.
+ */
+#define DSHOT_TELEM_FRAME_BITS  21
+#define DSHOT_TELEM_MIN_BITS    19      /* Idle-level bits after the last edge are not captured (<= 2) */
+#define DSHOT_TELEM_MIN_EDGES   9       /* Start edge + at least two GCR '1's per symbol */
+#define DSHOT_GCR_BITS          5       /* 5 GCR bits per nibble */
+#define DSHOT_TELEM_NIBBLES     4       /* 4 nibbles in response */
+#define DSHOT_TELEM_STOPPED     0x0FFF  /* Value reported for a stopped motor */
+
+/* Extended DShot Telemetry (EDT)
+ * Once enabled (DSHOT_CMD_EXTENDED_TELEM_ENABLE), the ESC interleaves
+ * other data with the eRPM frames. eRPM periods are normalized (mantissa
+ * MSB set whenever the exponent is non-zero), so a value with a non-zero
+ * exponent and bit 8 clear is an EDT frame: bits 11-8 are the type and
+ * bits 7-0 the data.
+ */
+#define DSHOT_EDT_TYPE_MASK     0x0F00
+#define DSHOT_EDT_TEMPERATURE   0x0200  /* Degrees C */
+#define DSHOT_EDT_VOLTAGE       0x0400  /* 0.25 V per step */
+#define DSHOT_EDT_CURRENT       0x0600  /* 1 A per step */
+#define DSHOT_EDT_DEBUG1        0x0800
+#define DSHOT_EDT_DEBUG2        0x0A00
+#define DSHOT_EDT_STRESS        0x0C00  /* Stress level 0-255 */
+#define DSHOT_EDT_STATUS        0x0E00  /* Flags below + max stress */
+#define DSHOT_EDT_IS_EXTENDED(value) \
+    ((((value) & 0x0100) == 0) && (((value) & 0x0E00) != 0))
+#define DSHOT_EDT_BIT(type)     (1U << ((type) >> 9))   /* dshot_edt_t.received flag */
+
+#define DSHOT_EDT_STATUS_ALERT  (1 << 7)
+#define DSHOT_EDT_STATUS_WARN   (1 << 6)
+#define DSHOT_EDT_STATUS_ERROR  (1 << 5)
+#define DSHOT_EDT_STATUS_STRESS 0x0F    /* Max stress level since last status */
+
+/* eRPM conversion backend
+ * 1: 512-entry reciprocal table indexed by the period mantissa, shifted by
+ *    the exponent (no division; 2 KB of flash). The result is within
+ *    0.51 eRPM of 60,000,000 / period_us, i.e. at most 1 eRPM from the
+ *    rounded division (2 of the 2303 eRPM values differ, and one EDT
+ *    code that is never converted; make bench reports both).
+ * 0: rounded 32-bit division per frame.
+ */
+#ifndef DSHOT_ERPM_TABLE
+#define DSHOT_ERPM_TABLE        1
+#endif
+#define DSHOT_ERPM_TABLE_SHIFT  6       /* Table entries are Q6 eRPM */
+
+/* Run-length table for dshot_edges_to_bits_table(): edge deltas are
+ * quantized to steps of at most 1/16 bit, covering deltas up to 6 bits
+ */
+#define DSHOT_EDGE_TABLE_SIZE   (6 * 32 + 1)
+
+/* Receive clock recovery: ratio of nominal to actual ESC bit period,
+ * 16.16 fixed point. ESC oscillators drift a few percent with temperature;
+ * the per-motor estimate follows 1/8 of each valid frame's error.
+ */
+#define DSHOT_RX_SCALE_ONE      (1UL << 16)
+#define DSHOT_RX_SCALE_MIN      (DSHOT_RX_SCALE_ONE * 88 / 100)     /* ESC ~14% slow */
+#define DSHOT_RX_SCALE_MAX      (DSHOT_RX_SCALE_ONE * 112 / 100)    /* ESC ~11% fast */
+#define DSHOT_RX_SCALE_FILTER_SHIFT 3
+
+/* Motor pole count for RPM calculation */
+#ifndef MOTOR_POLES
+#define MOTOR_POLES             14
+#endif
+
+/**
+ * @brief Timer constants derived from a timer clock and protocol speed
+ */
+typedef struct {
+    uint16_t period;            /* Timer ticks per DShot bit */
+    uint16_t bit_0_high;        /* CCR value for '0' (inverted duty) */
+    uint16_t bit_1_high;        /* CCR value for '1' (inverted duty) */
+    uint16_t telem_bit;         /* Timer ticks per telemetry bit */
+} dshot_timing_t;
+
+/**
+ * @brief Precomputed edge delta -> run length map for one telemetry bit period
+ */
+typedef struct {
+    uint16_t bit_period;                    /* Nominal ticks per telemetry bit */
+    uint8_t  shift;                         /* Quantization: index = delta >> shift */
+    uint16_t size;                          /* Used entries in run[] */
+    uint8_t  run[DSHOT_EDGE_TABLE_SIZE];    /* Bits per quantized delta (1-5) */
+} dshot_edge_table_t;
+
+/* Link quality: share of valid responses over the last N telemetry frames */
+#ifndef DSHOT_LINK_QUALITY_WINDOW
+#define DSHOT_LINK_QUALITY_WINDOW   32      /* Frames (1-64) */
+#endif
+
+#if DSHOT_LINK_QUALITY_WINDOW < 1 || DSHOT_LINK_QUALITY_WINDOW > 64
+#error "DSHOT_LINK_QUALITY_WINDOW must be 1-64"
+#endif
+
+/**
+ * @brief Outcome of one telemetry reception
+ */
+typedef enum {
+    DSHOT_TELEM_OK = 0,
+    DSHOT_TELEM_ERR_TIMEOUT,    /* No response within the capture window */
+    DSHOT_TELEM_ERR_EDGES,      /* Fewer than DSHOT_TELEM_MIN_EDGES edges */
+    DSHOT_TELEM_ERR_BITS,       /* Fewer than DSHOT_TELEM_MIN_BITS bits recovered */
+    DSHOT_TELEM_ERR_GCR,        /* Invalid GCR symbol */
+    DSHOT_TELEM_ERR_CRC,        /* CRC mismatch */
+    DSHOT_TELEM_EDT,            /* Valid EDT frame: no new eRPM sample */
+    DSHOT_TELEM_RESULT_COUNT
+} dshot_telem_result_t;
+
+/* Response decoded and CRC-checked, eRPM or EDT */
+#define DSHOT_TELEM_VALID(result)   ((result) == DSHOT_TELEM_OK || (result) == DSHOT_TELEM_EDT)
+
+/**
+ * @brief Extended DShot Telemetry values
+ *
+ * Each field is updated whenever a frame of its type arrives; the ESC
+ * chooses the rate per type.
+ */
+typedef struct {
+    uint8_t  temperature;       /* Degrees C */
+    uint8_t  voltage;           /* 0.25 V units */
+    uint8_t  current;           /* A */
+    uint8_t  debug1;
+    uint8_t  debug2;
+    uint8_t  stress;            /* Stress level 0-255 */
+    uint8_t  status;            /* DSHOT_EDT_STATUS_* */
+    uint8_t  received;          /* DSHOT_EDT_BIT() of every type seen */
+} dshot_edt_t;
+
+/**
+ * @brief Timestamps of one reception
+ *
+ * Free-running 32-bit counts of the driver's time base (dshot_time_now(),
+ * the DWT cycle counter on target); compare with unsigned subtraction.
+ */
+typedef struct {
+    uint32_t sent;              /* Frame DMA started */
+    uint32_t capture_start;     /* Pin switched to input, capture running */
+    uint32_t capture_end;       /* Window closed or capture buffer full */
+    uint32_t decoded;           /* Decode finished, record about to be published */
+} dshot_telem_times_t;
+
+/**
+ * @brief Bidirectional telemetry data
+ */
+typedef struct {
+    uint32_t erpm;              /* Electrical RPM */
+    uint32_t rpm;               /* Actual RPM (accounting for motor poles) */
+    uint32_t erpm_filtered;     /* erpm after spike rejection and low-pass (dshot_filter.h) */
+    int32_t  rpm_accel;         /* RPM/s from erpm_filtered (DSHOT_ERPM_MOTION, else 0) */
+    int32_t  rpm_jerk;          /* RPM/s^2 (DSHOT_ERPM_MOTION, else 0) */
+    uint16_t period_us;         /* Period in microseconds (raw from ESC) */
+    bool     valid;             /* Data validity flag */
+    uint32_t last_update;       /* times.decoded of the last eRPM packet */
+    dshot_telem_times_t times;  /* Latest reception, valid or not */
+    uint32_t frame_count;       /* Total frames sent */
+    uint32_t success_count;     /* Valid eRPM receptions (new samples) */
+    uint32_t edt_count;         /* Valid EDT receptions */
+    uint32_t error_count;       /* All failed receptions */
+    uint32_t errors[DSHOT_TELEM_RESULT_COUNT];  /* Failures per dshot_telem_result_t cause */
+    uint8_t  link_quality;      /* Valid responses (eRPM or EDT) over the last window, percent */
+    uint8_t  lq_frames;         /* Frames in the window so far */
+    uint8_t  lq_good;           /* Valid frames in the window */
+    uint64_t lq_history;        /* One bit per frame, 1 = valid, newest in bit 0 */
+    dshot_edt_t edt;            /* Extended telemetry (EDT frames) */
+} dshot_telemetry_t;
+
+/**
+ * @brief Compute timer constants for a timer clock and protocol speed
+ *
+ * All values are rounded to the nearest timer tick.
+ *
+ * @param timing Destination
+ * @param timer_clock_hz Timer kernel clock
+ * @param speed_kbit 150, 300, 600 or 1200
+ */
+void dshot_timing_init(dshot_timing_t *timing, uint32_t timer_clock_hz, uint16_t speed_kbit);
+
+/**
+ * @brief Create a 16-bit DShot packet with CRC
+ *
+ * Packet format: [11-bit value][1-bit telemetry request][4-bit CRC].
+ * Shared by the timer, burst and bit-bang output engines.
+ *
+ * @param value Throttle (48-2047) or command (0-47)
+ * @param request_telemetry Telemetry request flag
+ * @return Packet, MSB first on the wire
+ */
+uint16_t dshot_create_packet(uint16_t value, bool request_telemetry);
+
+/**
+ * @brief Encode a packet as CCR values, MSB first, plus a trailing idle word
+ *
+ * Writes DSHOT_FRAME_SIZE + 1 words, stride words apart (1 for a single
+ * channel, 4 for an interleaved burst buffer).
+ *
+ * @param buffer Destination
+ * @param timing Duty values for the target timer
+ * @param packet Packet from dshot_create_packet()
+ * @param stride Distance between consecutive words
+ */
+void dshot_encode_frame(uint32_t *buffer, const dshot_timing_t *timing,
+                        uint16_t packet, uint8_t stride);
+
+/**
+ * @brief Convert captured edge timestamps to response bits
+ *
+ * Each interval between consecutive edges covers round(delta / bit_period)
+ * bits of one level, starting low (= 1) at the first edge. 16-bit timer
+ * wrap-around is handled.
+ *
+ * @param edges Capture timestamps in timer ticks
+ * @param edge_count Number of valid entries in edges[]
+ * @param bit_period Timer ticks per telemetry bit
+ * @param raw_bits Response bits, MSB first (line low = 1)
+ * @return Number of bits recovered (at most DSHOT_TELEM_FRAME_BITS)
+ */
+uint8_t dshot_edges_to_bits(const uint16_t *edges, uint8_t edge_count,
+                            uint16_t bit_period, uint32_t *raw_bits);
+
+/**
+ * @brief Build the run-length table for dshot_edges_to_bits_table()
+ *
+ * The quantization step is the largest power of two not above
+ * bit_period / 16, so rounding decisions move by at most 1/16 bit
+ * compared to dshot_edges_to_bits().
+ *
+ * @param table Destination
+ * @param bit_period Timer ticks per telemetry bit (16 or more)
+ */
+void dshot_edge_table_init(dshot_edge_table_t *table, uint16_t bit_period);
+
+/**
+ * @brief Convert captured edge timestamps to response bits (table-driven)
+ *
+ * Same result as dshot_edges_to_bits() without a divide or per-bit loop:
+ * each edge delta is quantized, mapped to a run length through the table
+ * and the whole run is shifted into the word at once. Deltas are first
+ * multiplied by scale_q16 so a drifting ESC clock maps onto the nominal
+ * table (one multiply per edge).
+ *
+ * @param table Table built for the nominal telemetry bit period
+ * @param edges Capture timestamps in timer ticks
+ * @param edge_count Number of valid entries in edges[]
+ * @param scale_q16 Nominal / actual bit period (DSHOT_RX_SCALE_ONE if unknown)
+ * @param raw_bits Response bits, MSB first (line low = 1)
+ * @return Number of bits recovered (at most DSHOT_TELEM_FRAME_BITS)
+ */
+uint8_t dshot_edges_to_bits_table(const dshot_edge_table_t *table, const uint16_t *edges,
+                                  uint8_t edge_count, uint32_t scale_q16, uint32_t *raw_bits);
+
+/**
+ * @brief Refine the receive clock estimate from a successfully decoded frame
+ *
+ * The frame's length in ticks (first to last used edge) divided by the
+ * number of bits it was decoded as gives this frame's actual bit period.
+ * The estimate moves 1/2^DSHOT_RX_SCALE_FILTER_SHIFT of the way towards
+ * it and is clamped to DSHOT_RX_SCALE_MIN..DSHOT_RX_SCALE_MAX.
+ *
+ * Call only for frames that passed GCR and CRC checks, with the same
+ * edges and scale that decoded them.
+ *
+ * @param table Table built for the nominal telemetry bit period
+ * @param edges Capture timestamps in timer ticks
+ * @param edge_count Number of valid entries in edges[]
+ * @param scale_q16 Estimate used to decode the frame
+ * @return Updated estimate
+ */
+uint32_t dshot_rx_scale_update(const dshot_edge_table_t *table, const uint16_t *edges,
+                               uint8_t edge_count, uint32_t scale_q16);
+
+/**
+ * @brief Convert oversampled line levels to response bits
+ *
+ * The line idles high; the response starts with the first low sample.
+ * Each run between level changes covers round(run / samples_per_bit)
+ * bits of the current level (low = 1). Bits after the last edge are at
+ * the idle level and pad the word to DSHOT_TELEM_FRAME_BITS.
+ *
+ * @param samples Port input samples (e.g. GPIOx->IDR)
+ * @param sample_count Number of samples
+ * @param pin_mask Bit of the line within each sample
+ * @param samples_per_bit_q8 Samples per telemetry bit, 8.8 fixed point
+ * @param raw_bits Response bits, MSB first (line low = 1)
+ * @return DSHOT_TELEM_OK, DSHOT_TELEM_ERR_TIMEOUT if the line never went
+ *         low, DSHOT_TELEM_ERR_BITS if fewer than DSHOT_TELEM_MIN_BITS
+ *         bits were recovered
+ */
+dshot_telem_result_t dshot_samples_to_bits(const uint16_t *samples, uint16_t sample_count, uint16_t pin_mask,
+                                           uint32_t samples_per_bit_q8, uint32_t *raw_bits);
+
+/**
+ * @brief Decode 20 GCR bits into the 16-bit telemetry value
+ * @param gcr_value Four 5-bit symbols, MSB first
+ * @return Decoded value, or 0xFFFFFFFF for an invalid symbol
+ */
+uint32_t dshot_decode_gcr(uint32_t gcr_value);
+
+/**
+ * @brief Convert the 12-bit eRPM value to a period
+ * @param value eee mmmmmmmmm
+ * @return Period in microseconds (mantissa << exponent)
+ */
+uint32_t dshot_telem_period_us(uint16_t value);
+
+/**
+ * @brief Convert a period to eRPM (rounded, integer only)
+ *
+ * Exact reference for dshot_erpm_from_value(); uses a 32-bit division.
+ *
+ * @param period_us Electrical revolution period in microseconds
+ * @return eRPM, 0 for a zero period
+ */
+uint32_t dshot_erpm_from_period(uint32_t period_us);
+
+/**
+ * @brief Convert the 12-bit eRPM value straight to eRPM
+ *
+ * Uses the backend selected by DSHOT_ERPM_TABLE. Any value converts as
+ * the period mantissa << exponent, including non-normalized ones; the
+ * frame decoder does not call it for DSHOT_TELEM_STOPPED or EDT frames.
+ *
+ * @param value eee mmmmmmmmm
+ * @return eRPM, 0 for a zero period
+ */
+uint32_t dshot_erpm_from_value(uint16_t value);
+
+/**
+ * @brief Convert an eRPM rate (acceleration, jerk) to the RPM rate
+ *
+ * Divides by the pole pairs directly, so the saturated rates of the
+ * motion estimate (INT32_MIN / INT32_MAX) convert without overflow.
+ *
+ * @param erpm_rate eRPM/s or eRPM/s^2
+ * @return RPM/s or RPM/s^2, truncated towards zero
+ */
+int32_t dshot_rpm_rate_from_erpm(int32_t erpm_rate);
+
+/**
+ * @brief Decode a sampled 21-bit telemetry response
+ *
+ * Undoes the transition encoding, verifies GCR symbols and the inverted
+ * CRC, then stores period, eRPM and RPM. DSHOT_TELEM_STOPPED reads as
+ * 0 eRPM. EDT frames update the matching field of telemetry->edt, leave
+ * the eRPM fields alone and return DSHOT_TELEM_EDT, so callers do not
+ * count them as eRPM samples. The frame/success/error counters are left
+ * to the caller (dshot_telem_account()).
+ *
+ * Example: eRPM value 0x0C8 (mantissa 200, exponent 0 -> 200us, 300000
+ * eRPM) has CRC 0xB, GCR 0xCFB4B and arrives as line word 0x175272.
+ *
+ * @param raw_bits Line levels as sampled, MSB (start bit) first, line low = 1,
+ *                 padded with idle (0) bits to DSHOT_TELEM_FRAME_BITS
+ * @param telemetry Destination
+ * @return DSHOT_TELEM_OK (eRPM), DSHOT_TELEM_EDT, DSHOT_TELEM_ERR_GCR or
+ *         DSHOT_TELEM_ERR_CRC
+ */
+dshot_telem_result_t dshot_decode_gcr_frame(uint32_t raw_bits, dshot_telemetry_t *telemetry);
+
+/**
+ * @brief Clear telemetry data, counters and link quality
+ * @param telemetry Destination
+ */
+void dshot_telem_reset(dshot_telemetry_t *telemetry);
+
+/**
+ * @brief Count one reception outcome
+ *
+ * Updates the eRPM/EDT/error counters, the per-cause error counter and
+ * the link quality window (a shift register with a running count, so
+ * the cost is constant), and sets valid on an eRPM frame. Both eRPM and
+ * EDT frames count as good for link quality.
+ *
+ * @param telemetry Destination
+ * @param result Outcome of the reception
+ */
+void dshot_telem_account(dshot_telemetry_t *telemetry, dshot_telem_result_t result);
+
+#endif /* DSHOT_PROTO_H */
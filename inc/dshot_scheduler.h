@@ -0,0 +1,186 @@
+/**
+ * @file dshot_scheduler.h
+ * @brief Hardware-timed DShot frame scheduler
+ *
+ * A dedicated timer update interrupt sends one frame per motor at a fixed
+ * rate (1, 2, 4 or 8 kHz), always using the most recently commanded
+ * throttle. While the scheduler runs it also drives the bidirectional
+ * telemetry state machine (dshot_update()) once per tick, so the main
+ * loop must not call dshot_update() itself.
+ *
+ * Special commands go through a per-motor FIFO. Each entry is sent
+ * `repeat` times on consecutive ticks in place of the throttle frame;
+ * after the last repeat the motor returns to throttle frames for at
+ * least `spacing_us` before the next entry starts. Queuing never blocks.
+ */
+
+#ifndef DSHOT_SCHEDULER_H
+#define DSHOT_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dshot_governor.h"
+#include "dshot_health.h"
+
+/* Scheduler timer - ADJUST FOR YOUR BOARD
+ * TIM5 is a 32-bit APB1 timer clocked at 84MHz (APB1 42MHz x2).
+ */
+#define DSHOT_SCHED_TIMER           TIM5
+#define DSHOT_SCHED_TIMER_RCC       RCC_APB1ENR_TIM5EN
+#define DSHOT_SCHED_TIMER_IRQn      TIM5_IRQn
+#define DSHOT_SCHED_TIMER_CLOCK_HZ  84000000UL
+#define DSHOT_SCHED_IRQ_PRIORITY    2       /* Below the DShot DMA interrupts (1) */
+
+/* Supported frame rates */
+#define DSHOT_SCHED_RATE_1KHZ       1000
+#define DSHOT_SCHED_RATE_2KHZ       2000
+#define DSHOT_SCHED_RATE_4KHZ       4000
+#define DSHOT_SCHED_RATE_8KHZ       8000
+#define DSHOT_SCHED_DEFAULT_RATE    DSHOT_SCHED_RATE_1KHZ
+
+/* Command queue */
+#define DSHOT_CMD_QUEUE_SIZE        8       /* Entries per motor (power of two) */
+#define DSHOT_CMD_REPEAT_SETTINGS   6       /* Repeats required for settings commands */
+#define DSHOT_CMD_SPACING_US        1000    /* Default gap after a command */
+#define DSHOT_CMD_BEEP_SPACING_US   260000  /* Beeps last up to 260ms */
+#define DSHOT_CMD_ESC_INFO_SPACING_US 12000 /* ESC info reply time */
+
+/**
+ * @brief Scheduler timing statistics
+ *
+ * Intervals are measured between consecutive scheduler interrupts from
+ * the interrupt entry latency relative to the timer update event.
+ */
+typedef struct {
+    uint32_t rate_hz;           /* Configured frame rate */
+    uint32_t ticks;             /* Scheduler interrupts since start/reset */
+    uint32_t frames_sent;       /* Frames armed (all motors) */
+    uint32_t busy_skips;        /* Ticks where a motor was still busy */
+    uint32_t commands_sent;     /* Command frames armed (all motors) */
+    uint32_t interval_min_ns;   /* Shortest measured inter-frame interval */
+    uint32_t interval_max_ns;   /* Longest measured inter-frame interval */
+    uint32_t jitter_max_ns;     /* Largest deviation from the nominal interval */
+    uint32_t latency_max_ns;    /* Largest update-event-to-ISR latency */
+} dshot_scheduler_stats_t;
+
+/**
+ * @brief Start sending frames at a fixed rate
+ * @param rate_hz Frame rate (DSHOT_SCHED_RATE_1KHZ .. DSHOT_SCHED_RATE_8KHZ)
+ * @return true if started, false for an unsupported rate
+ */
+bool dshot_scheduler_start(uint32_t rate_hz);
+
+/**
+ * @brief Stop the scheduler (frames in flight complete normally)
+ */
+void dshot_scheduler_stop(void);
+
+/**
+ * @brief Check if the scheduler is running
+ * @return true if running
+ */
+bool dshot_scheduler_running(void);
+
+/**
+ * @brief Set the throttle sent to a motor on every following tick
+ * @param motor Motor index into dshot_ports[]
+ * @param throttle Throttle value (48-2047, or 0-47 for special commands)
+ */
+void dshot_scheduler_set_throttle(uint8_t motor, uint16_t throttle);
+
+/**
+ * @brief Hold a motor at an RPM with the closed-loop governor
+ *
+ * On every tick with a fresh telemetry sample the motor's governor
+ * (dshot_governor.h) updates the throttle from the filtered eRPM. While
+ * the last valid sample is older than DSHOT_GOVERNOR_TIMEOUT_US the motor
+ * runs open loop at fallback_throttle; closed loop resumes from that
+ * throttle when telemetry returns. dshot_scheduler_set_throttle() leaves
+ * governor mode.
+ *
+ * @param motor Motor index into dshot_ports[]
+ * @param rpm Mechanical RPM setpoint (0 stops the motor)
+ * @param fallback_throttle Open-loop throttle, also the starting point
+ */
+void dshot_scheduler_set_rpm(uint8_t motor, uint32_t rpm, uint16_t fallback_throttle);
+
+/**
+ * @brief Replace the governor tuning of all motors
+ * @param config Tuning (copied)
+ */
+void dshot_scheduler_set_governor(const dshot_governor_config_t *config);
+
+/**
+ * @brief Check whether a motor is currently under closed-loop control
+ * @param motor Motor index into dshot_ports[]
+ * @return true in governor mode with fresh telemetry
+ */
+bool dshot_scheduler_governor_engaged(uint8_t motor);
+
+/**
+ * @brief Latched stall / desync / collapse flags of a motor
+ *
+ * Updated on every tick from the commanded throttle and the telemetry
+ * snapshot (dshot_health.h). With auto_cut set, a motor with a fault is
+ * sent motor stop until dshot_scheduler_clear_faults(); a governed motor
+ * then restarts from its fallback throttle.
+ *
+ * @param motor Motor index into dshot_ports[]
+ * @return DSHOT_HEALTH_* flags, 0 if healthy
+ */
+uint8_t dshot_scheduler_get_faults(uint8_t motor);
+
+/**
+ * @brief Clear the latched faults of a motor (learned bands are kept)
+ * @param motor Motor index into dshot_ports[]
+ */
+void dshot_scheduler_clear_faults(uint8_t motor);
+
+/**
+ * @brief Replace the stall / desync detector tuning of all motors
+ * @param config Tuning (copied)
+ */
+void dshot_scheduler_set_health(const dshot_health_config_t *config);
+
+/**
+ * @brief Queue a special command with explicit repeat count and spacing
+ * @param motor Motor index into dshot_ports[]
+ * @param command DShot command (0-47)
+ * @param repeat Consecutive frames to send (1-255)
+ * @param spacing_us Minimum gap after the last frame before the next entry
+ * @return true if queued, false if the motor's queue is full or arguments are invalid
+ */
+bool dshot_scheduler_queue_command(uint8_t motor, uint8_t command, uint8_t repeat, uint32_t spacing_us);
+
+/**
+ * @brief Queue a special command with the repeat count and spacing it requires
+ *
+ * Spin direction, 3D mode, save settings and extended telemetry commands
+ * are repeated DSHOT_CMD_REPEAT_SETTINGS times; beeps and ESC info get
+ * their reply time as spacing.
+ *
+ * @param motor Motor index into dshot_ports[]
+ * @param command DShot command (0-47)
+ * @return true if queued
+ */
+bool dshot_scheduler_send_command(uint8_t motor, uint8_t command);
+
+/**
+ * @brief Check if a motor still has queued or in-progress commands
+ * @param motor Motor index into dshot_ports[]
+ * @return true if commands are pending
+ */
+bool dshot_scheduler_command_pending(uint8_t motor);
+
+/**
+ * @brief Get scheduler timing statistics
+ * @param stats Destination
+ */
+void dshot_scheduler_get_stats(dshot_scheduler_stats_t *stats);
+
+/**
+ * @brief Reset scheduler timing statistics
+ */
+void dshot_scheduler_reset_stats(void);
+
+#endif /* DSHOT_SCHEDULER_H */
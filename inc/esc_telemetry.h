@@ -8,10 +8,11 @@
  * With bidirectional DShot:
  * - Telemetry is received on PA8 (same pin as DShot output)
  * - No separate UART wire needed
- * - Only eRPM data is available (no voltage/current/temperature)
+ * - Basic telemetry carries eRPM only
+ * - With EDT (Extended DShot Telemetry) enabled, the ESC also reports
+ *   temperature, voltage, current, stress and status on the same wire
  *
- * For full telemetry (voltage, current, temp), use ESCs that support
- * the separate serial telemetry wire, or EDT (Extended DShot Telemetry).
+ * Consumption is not part of EDT and stays 0.
  */
 
 #ifndef ESC_TELEMETRY_H
@@ -23,21 +24,30 @@
 /* Motor Configuration */
 #define MOTOR_POLES             14      /* Motor pole pairs (adjust for your motor) */
 
+/* Request Extended DShot Telemetry after arming (1 = enabled) */
+#ifndef ESC_TELEMETRY_EDT
+#define ESC_TELEMETRY_EDT       1
+#endif
+
 /**
  * @brief ESC telemetry data structure
  *
- * With basic bidirectional DShot, only RPM data is available.
- * Voltage, current, and temperature fields are set to 0.
+ * With basic bidirectional DShot, only RPM data is available. The EDT
+ * fields stay 0 until the ESC has sent a frame of that type; edt_valid
+ * is set once any EDT frame has been received.
  */
 typedef struct {
-    uint8_t  temperature;       /* Temperature in °C (not available in basic bidir) */
-    uint16_t voltage;           /* Voltage in 0.01V units (not available in basic bidir) */
-    uint16_t current;           /* Current in 0.01A units (not available in basic bidir) */
-    uint16_t consumption;       /* Consumption in mAh (not available in basic bidir) */
+    uint8_t  temperature;       /* Temperature in °C (EDT) */
+    uint16_t voltage;           /* Voltage in 0.01V units (EDT, 0.25V resolution) */
+    uint16_t current;           /* Current in 0.01A units (EDT, 1A resolution) */
+    uint16_t consumption;       /* Consumption in mAh (not available over DShot) */
     uint16_t erpm;              /* Electrical RPM / 100 */
     uint32_t rpm;               /* Actual RPM (calculated from eRPM and poles) */
+    uint8_t  stress;            /* ESC stress level 0-255 (EDT) */
+    uint8_t  status;            /* DSHOT_EDT_STATUS_* flags (EDT) */
+    bool     edt_valid;         /* At least one EDT frame received */
     bool     valid;             /* Data validity flag */
-    uint32_t last_update;       /* Timestamp of last valid packet */
+    uint32_t last_update;       /* dshot_time_now() of last valid packet */
 } esc_telemetry_t;
 
 /**
@@ -50,6 +60,17 @@ typedef struct {
  */
 bool esc_telemetry_init(void);
 
+/**
+ * @brief Ask the ESC to enable Extended DShot Telemetry
+ *
+ * Queues DSHOT_CMD_EXTENDED_TELEM_ENABLE with the repeat count the ESC
+ * requires for settings commands. The ESC only accepts it once armed, so
+ * call after the arming sequence with the scheduler running.
+ *
+ * @return true if the command was queued
+ */
+bool esc_telemetry_enable_edt(void);
+
 /**
  * @brief Process incoming telemetry data
  *
@@ -80,13 +101,13 @@ bool esc_telemetry_available(void);
 
 /**
  * @brief Get voltage as float in volts
- * @return 0.0 (not available with basic bidirectional DShot)
+ * @return Last EDT voltage, 0.0 until one has been received
  */
 float esc_telemetry_get_voltage_v(void);
 
 /**
  * @brief Get current as float in amps
- * @return 0.0 (not available with basic bidirectional DShot)
+ * @return Last EDT current, 0.0 until one has been received
  */
 float esc_telemetry_get_current_a(void);
 
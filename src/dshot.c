@@ -5,129 +5,310 @@
  * Implements DShot600 with bidirectional telemetry on a single wire.
  * After sending the command frame, the GPIO switches to input mode
  * to capture the ESC's GCR-encoded telemetry response.
+ *
+ * Every motor is described by a dshot_port_t entry in dshot_ports[] and
+ * owns one dshot_motor_t instance; all instances run through the same
+ * state machine.
  */
 
+#include <stddef.h>
 #include "dshot.h"
+#include "dshot_bitbang.h"
+#include "dshot_capture.h"
 #include "stm32f4xx.h"
 
-/* DMA buffer for DShot frame transmission */
-static uint16_t dshot_dma_buffer[DSHOT_FRAME_SIZE + 1];  /* +1 for trailing zero */
+#if DSHOT_IC_BUFFER_SIZE > DSHOT_CAPTURE_MAX_EDGES
+#error "DSHOT_CAPTURE_MAX_EDGES must hold a full input capture buffer"
+#endif
 
-/* Input capture buffer for telemetry reception */
-static uint16_t dshot_ic_buffer[DSHOT_IC_BUFFER_SIZE];
-static volatile uint8_t ic_edge_count = 0;
+/* Board configuration - ADJUST FOR YOUR BOARD
+ *
+ * Default: one motor on TIM1_CH1 (PA8), TX on DMA2 Stream 1 channel 6,
+ * input capture on DMA2 Stream 6 channel 0.
+ *
+ * Further motors are added by appending entries and raising
+ * DSHOT_MOTOR_COUNT, e.g. TIM3_CH1 on PB4 (AF2, APB1 timer clock 84MHz)
+ * using DMA1 Stream 4 channel 5 for both directions:
+ *
+ *   { TIM3, 84000000UL, 1, GPIOB, 4, 2,
+ *     DMA1, DMA1_Stream4, 4, 5, DMA1_Stream4_IRQn,
+ *           DMA1_Stream4, 4, 5, DMA1_Stream4_IRQn,
+ *     RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_DMA1EN, RCC_APB1ENR_TIM3EN, 0 },
+ *
+ * TIM8 ports (STM32F405/407) follow the TIM1 pattern on DMA2 channel 7.
+ * Every stream used needs an IRQ handler calling dshot_dma_irq_handler().
+ */
+const dshot_port_t dshot_ports[DSHOT_MOTOR_COUNT] = {
+    {
+        .timer           = TIM1,
+        .timer_clock_hz  = TIMER_CLOCK_HZ,
+        .channel         = 1,
+        .gpio            = GPIOA,
+        .pin             = 8,       /* PA8 for TIM1_CH1 */
+        .af              = 1,       /* Alternate function for TIM1 */
+        .dma             = DMA2,
+        .tx_stream       = DMA2_Stream1,
+        .tx_stream_index = 1,
+        .tx_dma_channel  = 6,       /* DMA channel for TIM1_CH1 */
+        .tx_irq          = DMA2_Stream1_IRQn,
+        .ic_stream       = DMA2_Stream6,
+        .ic_stream_index = 6,
+        .ic_dma_channel  = 0,       /* DMA channel for TIM1_CH1 input capture */
+        .ic_irq          = DMA2_Stream6_IRQn,
+        .rcc_ahb1enr     = RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_DMA2EN,
+        .rcc_apb1enr     = 0,
+        .rcc_apb2enr     = RCC_APB2ENR_TIM1EN,
+    },
+};
 
-/* State tracking */
-static volatile dshot_state_t dshot_state = DSHOT_STATE_IDLE;
+/* Burst group: TIM1 CH1-CH4 on PA8-PA11, TIM1_UP on DMA2 Stream 5 channel 6 */
+const dshot_burst_port_t dshot_burst_port = {
+    .timer          = TIM1,
+    .timer_clock_hz = TIMER_CLOCK_HZ,
+    .gpio           = GPIOA,
+    .pins           = { 8, 9, 10, 11 },
+    .af             = 1,
+    .dma            = DMA2,
+    .stream         = DMA2_Stream5,
+    .stream_index   = 5,
+    .dma_channel    = 6,
+    .irq            = DMA2_Stream5_IRQn,
+    .rcc_ahb1enr    = RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_DMA2EN,
+    .rcc_apb1enr    = 0,
+    .rcc_apb2enr    = RCC_APB2ENR_TIM1EN,
+};
 
-/* Telemetry data */
-static dshot_telemetry_t telemetry = {0};
-static volatile bool new_telemetry_available = false;
+/**
+ * @brief Runtime state of one motor
+ */
+typedef struct {
+    const dshot_port_t *port;
+    volatile uint32_t *ccr;                 /* CCRx of the port's channel */
+    dshot_timing_t timing;
+    dshot_edge_table_t edge_table;          /* Edge decoder for timing.telem_bit */
+    uint32_t rx_scale;                      /* Nominal / actual ESC bit period, 16.16 */
+
+    /* Next receive window event on DSHOT_RX_TIMER, valid while rx_armed */
+    uint32_t rx_deadline;
+    volatile bool rx_armed;
+
+    /* Ping-pong DMA buffers for DShot frame transmission (32-bit entries to
+     * match the DMA word size). The front buffer is owned by DMA while a
+     * frame is on the wire; the next frame is encoded into the back buffer.
+     */
+    uint32_t dma_buffer[2][DSHOT_FRAME_SIZE + 1];  /* +1 for trailing zero */
+    uint8_t front;                          /* Index of the buffer last armed */
+    volatile bool back_ready;               /* Back buffer holds an unsent frame */
+    bool back_telemetry;                    /* Back frame requests telemetry */
+
+    /* Timestamps of the reception in progress, copied to telemetry.times
+     * when it is published */
+    dshot_telem_times_t times;
+
+    /* Input capture buffer for telemetry reception */
+    uint16_t ic_buffer[DSHOT_IC_BUFFER_SIZE];
+    volatile uint8_t ic_edge_count;
+
+    /* Stream ownership: set when a stream is enabled, cleared by its
+     * transfer-complete interrupt once the stream has stopped */
+    volatile bool tx_dma_busy;
+    volatile bool ic_dma_busy;
+
+    /* State tracking */
+    volatile dshot_state_t state;
+
+    /* Telemetry data: working copy owned by the decoder, and the published
+     * pair read by dshot_motor_read_telemetry() */
+    dshot_telemetry_t telemetry;
+    volatile bool new_telemetry_available;
+    dshot_erpm_filter_t erpm_filter;
+    dshot_erpm_motion_t erpm_motion;
+    dshot_telemetry_t telem_pub[2];
+    volatile uint32_t telem_seq;            /* Odd while telem_pub[0] is written */
+} dshot_motor_t;
+
+static dshot_motor_t dshot_motors[DSHOT_MOTOR_COUNT];
+
+/* Interleaved burst buffer: one word per channel per bit, CH1..CH4 order */
+static uint32_t dshot_burst_buffer[(DSHOT_FRAME_SIZE + 1) * DSHOT_BURST_MOTORS];
+static dshot_timing_t burst_timing;
+static volatile bool burst_busy = false;
+static bool burst_active = false;
+
+/* Current protocol speed in kbit/s */
+static uint16_t dshot_speed = DSHOT_SPEED;
+
+/* eRPM filter coefficients, shared by all motors */
+static dshot_erpm_filter_config_t erpm_filter_config;
+
+/* Decode cost in DWT cycles */
+static volatile uint32_t decode_count = 0;
+static volatile uint32_t decode_last_cycles = 0;
+static volatile uint32_t decode_max_cycles = 0;
+static volatile uint64_t decode_total_cycles = 0;
+
+/* DMA interrupt flag offsets within LIFCR/HIFCR for streams x%4 */
+static const uint8_t dma_flag_shift[4] = { 0, 6, 16, 22 };
 
-/* Simple tick counter for timing */
-static volatile uint32_t tick_counter = 0;
-static volatile uint32_t telem_start_time = 0;
+/* Private function prototypes */
+static void dshot_timer_reload(TIM_TypeDef *tim, const dshot_timing_t *timing);
+static void dshot_gpio_config_af(GPIO_TypeDef *gpio, uint8_t pin, uint8_t af);
+static void dshot_prepare_frame(dshot_motor_t *m, uint16_t packet, bool request_telemetry);
+static dshot_send_status_t dshot_arm_frame(dshot_motor_t *m);
+static void dshot_switch_to_output(dshot_motor_t *m);
+static void dshot_switch_to_input(dshot_motor_t *m);
+static void dshot_start_input_capture(dshot_motor_t *m);
+static void dshot_stop_input_capture(dshot_motor_t *m);
+static void dshot_rx_timer_program(void);
+static void dshot_rx_timer_arm(uint8_t motor, uint32_t delay_us);
+static void dshot_rx_timer_disarm(uint8_t motor);
+static void dshot_capture_done(dshot_motor_t *m);
+static void dshot_rx_watchdog(dshot_motor_t *m);
+static void dshot_process_capture(dshot_motor_t *m);
+static void dshot_publish_telemetry(dshot_motor_t *m);
+static dshot_telem_result_t dshot_decode_telemetry(dshot_motor_t *m);
 
-/* GCR decoding lookup table
- * Maps 5-bit GCR symbols to 4-bit nibbles
- * Invalid codes map to 0xFF
+/**
+ * @brief Load a new bit period into a running timer
+ *
+ * Every channel is parked at idle high before ARR changes so the counter
+ * restart cannot produce a low pulse the ESC would read as a frame.
  */
-static const uint8_t gcr_decode_table[32] = {
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,  /* 0x00-0x07 */
-    0xFF, 0x09, 0x0A, 0x0B, 0xFF, 0x0D, 0x0E, 0x0F,  /* 0x08-0x0F */
-    0xFF, 0xFF, 0x02, 0x03, 0xFF, 0x05, 0x06, 0x07,  /* 0x10-0x17 */
-    0xFF, 0x00, 0x08, 0x01, 0xFF, 0x04, 0x0C, 0xFF,  /* 0x18-0x1F */
-};
+static void dshot_timer_reload(TIM_TypeDef *tim, const dshot_timing_t *timing) {
+    tim->CCR1 = timing->period;
+    tim->CCR2 = timing->period;
+    tim->CCR3 = timing->period;
+    tim->CCR4 = timing->period;
+    tim->ARR = timing->period - 1;
+    tim->EGR = TIM_EGR_UG;                     /* Restart counter, load preloads */
+}
 
-/* Private function prototypes */
-static uint16_t dshot_create_packet(uint16_t value, bool request_telemetry);
-static void dshot_encode_dma_buffer(uint16_t packet);
-static void dshot_switch_to_output(void);
-static void dshot_switch_to_input(void);
-static void dshot_start_input_capture(void);
-static void dshot_stop_input_capture(void);
-static bool dshot_decode_telemetry(void);
-static uint32_t dshot_decode_gcr(uint32_t gcr_value);
+/**
+ * @brief Clear all interrupt flags of a DMA stream
+ */
+void dshot_dma_clear_flags(DMA_TypeDef *dma, uint8_t stream_index) {
+    uint32_t flags = 0x3DUL << dma_flag_shift[stream_index & 3];  /* TC, HT, TE, DME, FE */
+
+    if (stream_index < 4) {
+        dma->LIFCR = flags;
+    } else {
+        dma->HIFCR = flags;
+    }
+}
+
+/**
+ * @brief Configure a pin for timer alternate function output
+ */
+static void dshot_gpio_config_af(GPIO_TypeDef *gpio, uint8_t pin, uint8_t af) {
+    gpio->MODER &= ~(3UL << (pin * 2));
+    gpio->MODER |= (2UL << (pin * 2));       /* AF mode */
+    gpio->OSPEEDR |= (3UL << (pin * 2));     /* Very high speed */
+    gpio->PUPDR &= ~(3UL << (pin * 2));      /* No pull */
+    gpio->OTYPER &= ~(1UL << pin);           /* Push-pull */
+
+    /* Set alternate function */
+    gpio->AFR[pin >> 3] &= ~(0xFUL << ((pin & 7) * 4));
+    gpio->AFR[pin >> 3] |= ((uint32_t)af << ((pin & 7) * 4));
+}
 
 /**
  * @brief Initialize bidirectional DShot protocol
  */
 bool dshot_init(void) {
-    /* Enable clocks */
-    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;   /* Enable GPIOA clock */
-    RCC->APB2ENR |= DSHOT_TIMER_RCC;        /* Enable timer clock */
-    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;     /* Enable DMA2 clock */
-
-    /* Configure GPIO for PWM output initially */
-    dshot_switch_to_output();
-
-    /* Configure Timer for DShot PWM */
-    DSHOT_TIMER->CR1 = 0;                          /* Disable timer */
-    DSHOT_TIMER->PSC = 0;                          /* No prescaler */
-    DSHOT_TIMER->ARR = DSHOT_TIMER_PERIOD - 1;     /* Auto-reload value */
-
-    /* Configure channel 1 for PWM output */
-    DSHOT_TIMER->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M);
-    DSHOT_TIMER->CCMR1 |= (6 << 4);                /* PWM mode 1 */
-    DSHOT_TIMER->CCMR1 |= TIM_CCMR1_OC1PE;         /* Preload enable */
-
-    DSHOT_TIMER->CCER &= ~TIM_CCER_CC1P;           /* Active high */
-    DSHOT_TIMER->CCER |= TIM_CCER_CC1E;            /* Enable output */
-
-    DSHOT_TIMER->BDTR |= TIM_BDTR_MOE;             /* Main output enable */
-    DSHOT_TIMER->DIER |= TIM_DIER_CC1DE;           /* Enable DMA requests on CC1 */
-
-    DSHOT_TIMER->CCR1 = 0;                         /* Start with output low */
-
-    /* Configure DMA Stream 1 for frame transmission (Memory to Peripheral) */
-    DSHOT_DMA_STREAM->CR = 0;
-    while (DSHOT_DMA_STREAM->CR & DMA_SxCR_EN);
-
-    DSHOT_DMA_STREAM->CR = (DSHOT_DMA_CHANNEL << 25) |  /* Channel selection */
-                           (2 << 16) |  /* Memory data size: 32-bit */
-                           (2 << 13) |  /* Peripheral data size: 32-bit */
-                           (1 << 10) |  /* Memory increment mode */
-                           (1 << 6) |   /* Direction: Memory to peripheral */
-                           (1 << 4);    /* Transfer complete interrupt enable */
-
-    DSHOT_DMA_STREAM->PAR = (uint32_t)&DSHOT_TIMER->CCR1;
-    DSHOT_DMA_STREAM->M0AR = (uint32_t)dshot_dma_buffer;
-    DSHOT_DMA_STREAM->NDTR = DSHOT_FRAME_SIZE + 1;  /* +1 for trailing zero */
-
-    /* Configure DMA Stream 6 for input capture (Peripheral to Memory) */
-    DSHOT_IC_DMA_STREAM->CR = 0;
-    while (DSHOT_IC_DMA_STREAM->CR & DMA_SxCR_EN);
-
-    DSHOT_IC_DMA_STREAM->CR = (DSHOT_IC_DMA_CHANNEL << 25) |  /* Channel selection */
-                              (1 << 16) |  /* Memory data size: 16-bit */
-                              (1 << 13) |  /* Peripheral data size: 16-bit */
-                              (1 << 10) |  /* Memory increment mode */
-                              (0 << 6) |   /* Direction: Peripheral to memory */
-                              (1 << 4);    /* Transfer complete interrupt enable */
-
-    DSHOT_IC_DMA_STREAM->PAR = (uint32_t)&DSHOT_TIMER->CCR1;
-    DSHOT_IC_DMA_STREAM->M0AR = (uint32_t)dshot_ic_buffer;
-    DSHOT_IC_DMA_STREAM->NDTR = DSHOT_IC_BUFFER_SIZE;
-
-    /* Initialize buffer with trailing zero to ensure clean signal end */
-    dshot_dma_buffer[DSHOT_FRAME_SIZE] = 0;
-
-    /* Enable DMA interrupts */
-    NVIC_SetPriority(DMA2_Stream1_IRQn, 1);
-    NVIC_EnableIRQ(DMA2_Stream1_IRQn);
-    NVIC_SetPriority(DMA2_Stream6_IRQn, 1);
-    NVIC_EnableIRQ(DMA2_Stream6_IRQn);
-
-    /* Enable timer */
-    DSHOT_TIMER->CR1 |= TIM_CR1_CEN;
+    burst_active = false;
+
+    /* Cycle counter: telemetry time base and decode statistics */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    dshot_reset_decode_stats();
+    dshot_erpm_filter_config(&erpm_filter_config, DSHOT_ERPM_FILTER_ORDER,
+                             DSHOT_ERPM_FILTER_CUTOFF_HZ, DSHOT_ERPM_FILTER_RATE_HZ);
+
+    /* Receive window timer: free-running, compare channel 1 follows the
+     * soonest receive window deadline of all motors, its interrupt enabled
+     * only while one is pending */
+    RCC->APB1ENR |= DSHOT_RX_TIMER_RCC;
+    DSHOT_RX_TIMER->CR1 = 0;
+    DSHOT_RX_TIMER->PSC = 0;
+    DSHOT_RX_TIMER->ARR = 0xFFFFFFFF;
+    DSHOT_RX_TIMER->CCMR1 = 0;                     /* Frozen output compare */
+    DSHOT_RX_TIMER->CCMR2 = 0;
+    DSHOT_RX_TIMER->DIER = 0;
+    DSHOT_RX_TIMER->EGR = TIM_EGR_UG;
+    DSHOT_RX_TIMER->SR = 0;
+    NVIC_SetPriority(DSHOT_RX_TIMER_IRQn, DSHOT_RX_TIMER_IRQ_PRIORITY);
+    NVIC_EnableIRQ(DSHOT_RX_TIMER_IRQn);
+    DSHOT_RX_TIMER->CR1 = TIM_CR1_CEN;
+
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        dshot_motor_t *m = &dshot_motors[i];
+        const dshot_port_t *port = &dshot_ports[i];
+        TIM_TypeDef *tim = port->timer;
+
+        if (port->channel < 1 || port->channel > 4) {
+            return false;
+        }
 
-    dshot_state = DSHOT_STATE_IDLE;
+        m->port = port;
+        m->ccr = &tim->CCR1 + (port->channel - 1);
+        dshot_timing_init(&m->timing, port->timer_clock_hz, dshot_speed);
+        dshot_edge_table_init(&m->edge_table, m->timing.telem_bit);
+        m->rx_scale = DSHOT_RX_SCALE_ONE;
+
+        /* Enable clocks */
+        RCC->AHB1ENR |= port->rcc_ahb1enr;     /* GPIO and DMA clocks */
+        RCC->APB1ENR |= port->rcc_apb1enr;     /* Timer clock (APB1 timers) */
+        RCC->APB2ENR |= port->rcc_apb2enr;     /* Timer clock (APB2 timers) */
+
+        /* Configure Timer for DShot PWM (shared by every channel on this timer) */
+        tim->CR1 &= ~TIM_CR1_CEN;                  /* Disable timer */
+        tim->PSC = 0;                              /* No prescaler */
+        tim->ARR = m->timing.period - 1;           /* Auto-reload value */
+        tim->DCR = 0;
+        tim->DIER &= ~TIM_DIER_UDE;                /* Burst mode off */
+        tim->BDTR |= TIM_BDTR_MOE;                 /* Main output enable (advanced timers) */
+
+        /* Configure channel for PWM output */
+        *m->ccr = m->timing.period;                /* Start with output high (idle) */
+        dshot_switch_to_output(m);
+
+        /* Stop both streams; they are fully programmed on every transfer
+         * (one-time wait at init, the send path never polls EN) */
+        port->tx_stream->CR = 0;
+        while (port->tx_stream->CR & DMA_SxCR_EN);
+        port->ic_stream->CR = 0;
+        while (port->ic_stream->CR & DMA_SxCR_EN);
+        m->tx_dma_busy = false;
+        m->ic_dma_busy = false;
+
+        /* Initialize buffers with trailing zero to ensure clean signal end */
+        m->dma_buffer[0][DSHOT_FRAME_SIZE] = m->timing.period;
+        m->dma_buffer[1][DSHOT_FRAME_SIZE] = m->timing.period;
+        m->front = 0;
+        m->back_ready = false;
+
+        /* Enable DMA interrupts */
+        NVIC_SetPriority(port->tx_irq, DSHOT_DMA_IRQ_PRIORITY);
+        NVIC_EnableIRQ(port->tx_irq);
+        NVIC_SetPriority(port->ic_irq, DSHOT_DMA_IRQ_PRIORITY);
+        NVIC_EnableIRQ(port->ic_irq);
+
+        m->state = DSHOT_STATE_IDLE;
+
+        /* Initialize telemetry structure */
+        dshot_telem_reset(&m->telemetry);
+        dshot_erpm_filter_reset(&m->erpm_filter);
+        dshot_erpm_motion_reset(&m->erpm_motion);
+        m->new_telemetry_available = false;
+        m->telem_pub[0] = m->telemetry;
+        m->telem_pub[1] = m->telemetry;
+        m->telem_seq = 0;
+    }
 
-    /* Initialize telemetry structure */
-    telemetry.valid = false;
-    telemetry.frame_count = 0;
-    telemetry.success_count = 0;
-    telemetry.error_count = 0;
+    /* Enable timers once all channels are configured */
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        dshot_ports[i].timer->CR1 |= TIM_CR1_CEN;
+    }
 
     return true;
 }
@@ -135,102 +316,284 @@ bool dshot_init(void) {
 /**
  * @brief Switch GPIO to output mode (PWM)
  */
-static void dshot_switch_to_output(void) {
+static void dshot_switch_to_output(dshot_motor_t *m) {
+    const dshot_port_t *port = m->port;
+    TIM_TypeDef *tim = port->timer;
+    uint8_t idx = port->channel - 1;
+    volatile uint32_t *ccmr = (idx < 2) ? &tim->CCMR1 : &tim->CCMR2;
+    uint8_t ccmr_shift = (idx & 1) * 8;
+    uint8_t ccer_shift = idx * 4;
+
     /* Disable input capture */
-    DSHOT_TIMER->CCER &= ~TIM_CCER_CC1E;
+    tim->CCER &= ~(TIM_CCER_CC1E << ccer_shift);
 
     /* Configure for output compare (PWM) */
-    DSHOT_TIMER->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M);
-    DSHOT_TIMER->CCMR1 |= (6 << 4) | TIM_CCMR1_OC1PE;  /* PWM mode 1, preload */
+    *ccmr &= ~((TIM_CCMR1_CC1S | TIM_CCMR1_OC1M) << ccmr_shift);
+    *ccmr |= ((6 << 4) | TIM_CCMR1_OC1PE) << ccmr_shift;  /* PWM mode 1, preload */
 
     /* GPIO: Alternate function mode for timer output */
-    GPIOA->MODER &= ~(3 << (DSHOT_GPIO_PIN * 2));
-    GPIOA->MODER |= (2 << (DSHOT_GPIO_PIN * 2));       /* AF mode */
-    GPIOA->OSPEEDR |= (3 << (DSHOT_GPIO_PIN * 2));     /* Very high speed */
-    GPIOA->PUPDR &= ~(3 << (DSHOT_GPIO_PIN * 2));      /* No pull */
-    GPIOA->OTYPER &= ~(1 << DSHOT_GPIO_PIN);           /* Push-pull */
-
-    /* Set alternate function */
-    if (DSHOT_GPIO_PIN < 8) {
-        GPIOA->AFR[0] &= ~(0xF << (DSHOT_GPIO_PIN * 4));
-        GPIOA->AFR[0] |= (DSHOT_GPIO_AF << (DSHOT_GPIO_PIN * 4));
-    } else {
-        GPIOA->AFR[1] &= ~(0xF << ((DSHOT_GPIO_PIN - 8) * 4));
-        GPIOA->AFR[1] |= (DSHOT_GPIO_AF << ((DSHOT_GPIO_PIN - 8) * 4));
-    }
+    dshot_gpio_config_af(port->gpio, port->pin, port->af);
 
     /* Re-enable output compare */
-    DSHOT_TIMER->CCER &= ~TIM_CCER_CC1P;              /* Active high */
-    DSHOT_TIMER->CCER |= TIM_CCER_CC1E;               /* Enable output */
+    tim->CCER &= ~((TIM_CCER_CC1P | TIM_CCER_CC1NP) << ccer_shift);  /* Active high */
+    tim->CCER |= (TIM_CCER_CC1E << ccer_shift);                      /* Enable output */
 
     /* Enable DMA requests for output */
-    DSHOT_TIMER->DIER |= TIM_DIER_CC1DE;
+    tim->DIER |= (TIM_DIER_CC1DE << idx);
 }
 
 /**
  * @brief Switch GPIO to input mode for telemetry capture
  */
-static void dshot_switch_to_input(void) {
+static void dshot_switch_to_input(dshot_motor_t *m) {
+    const dshot_port_t *port = m->port;
+    TIM_TypeDef *tim = port->timer;
+    uint8_t idx = port->channel - 1;
+    volatile uint32_t *ccmr = (idx < 2) ? &tim->CCMR1 : &tim->CCMR2;
+    uint8_t ccmr_shift = (idx & 1) * 8;
+    uint8_t ccer_shift = idx * 4;
+
     /* Disable output */
-    DSHOT_TIMER->CCER &= ~TIM_CCER_CC1E;
-    DSHOT_TIMER->DIER &= ~TIM_DIER_CC1DE;
+    tim->CCER &= ~(TIM_CCER_CC1E << ccer_shift);
+    tim->DIER &= ~(TIM_DIER_CC1DE << idx);
 
-    /* Configure timer for input capture on channel 1 */
-    DSHOT_TIMER->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M | TIM_CCMR1_OC1PE);
-    DSHOT_TIMER->CCMR1 |= (1 << 0);  /* CC1S = 01: IC1 mapped to TI1 */
+    /* Configure timer for input capture on this channel */
+    *ccmr &= ~((TIM_CCMR1_CC1S | TIM_CCMR1_OC1M | TIM_CCMR1_OC1PE) << ccmr_shift);
+    *ccmr |= (TIM_CCMR1_CC1S_0 << ccmr_shift);  /* CCxS = 01: ICx mapped to TIx */
 
     /* GPIO: Still alternate function but timer will capture input */
-    GPIOA->MODER &= ~(3 << (DSHOT_GPIO_PIN * 2));
-    GPIOA->MODER |= (2 << (DSHOT_GPIO_PIN * 2));      /* AF mode */
-    GPIOA->PUPDR &= ~(3 << (DSHOT_GPIO_PIN * 2));
-    GPIOA->PUPDR |= (1 << (DSHOT_GPIO_PIN * 2));      /* Pull-up for idle high */
+    port->gpio->PUPDR &= ~(3UL << (port->pin * 2));
+    port->gpio->PUPDR |= (1UL << (port->pin * 2));     /* Pull-up for idle high */
 
     /* Enable input capture on both edges */
-    DSHOT_TIMER->CCER |= TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP;
+    tim->CCER |= (TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP) << ccer_shift;
 }
 
 /**
  * @brief Start input capture DMA for telemetry
  */
-static void dshot_start_input_capture(void) {
+static void dshot_start_input_capture(dshot_motor_t *m) {
+    const dshot_port_t *port = m->port;
+    DMA_Stream_TypeDef *stream = port->ic_stream;
+
     /* Clear any pending flags */
-    DMA2->HIFCR = DMA_HIFCR_CTCIF6 | DMA_HIFCR_CHTIF6 | DMA_HIFCR_CTEIF6 | DMA_HIFCR_CDMEIF6 | DMA_HIFCR_CFEIF6;
-    DSHOT_TIMER->SR = 0;
+    dshot_dma_clear_flags(port->dma, port->ic_stream_index);
+    port->timer->SR = ~(TIM_SR_CC1IF << (port->channel - 1));
 
     /* Reset buffer index */
-    ic_edge_count = 0;
-
-    /* Configure DMA for input capture */
-    DSHOT_IC_DMA_STREAM->CR &= ~DMA_SxCR_EN;
-    while (DSHOT_IC_DMA_STREAM->CR & DMA_SxCR_EN);
-
-    DSHOT_IC_DMA_STREAM->NDTR = DSHOT_IC_BUFFER_SIZE;
-    DSHOT_IC_DMA_STREAM->CR |= DMA_SxCR_EN;
+    m->ic_edge_count = 0;
+
+    /* Configure DMA for input capture (Peripheral to Memory); the caller
+     * has checked that the stream is stopped (ic_dma_busy clear) */
+    m->ic_dma_busy = true;
+    stream->CR = ((uint32_t)port->ic_dma_channel << 25) |  /* Channel selection */
+                 (1 << 16) |  /* Memory data size: 16-bit */
+                 (1 << 13) |  /* Peripheral data size: 16-bit */
+                 (1 << 10) |  /* Memory increment mode */
+                 (0 << 6) |   /* Direction: Peripheral to memory */
+                 (1 << 4);    /* Transfer complete interrupt enable */
+    stream->PAR = (uint32_t)m->ccr;
+    stream->M0AR = (uint32_t)m->ic_buffer;
+    stream->NDTR = DSHOT_IC_BUFFER_SIZE;
+    stream->CR |= DMA_SxCR_EN;
 
     /* Enable DMA requests for input capture */
-    DSHOT_TIMER->DIER |= TIM_DIER_CC1DE;
-
-    telem_start_time = tick_counter;
+    port->timer->DIER |= (TIM_DIER_CC1DE << (port->channel - 1));
 }
 
 /**
  * @brief Stop input capture
+ *
+ * Clearing EN does not stop the stream immediately. The stream raises
+ * its transfer-complete flag once it has actually stopped, and the
+ * interrupt handler then releases ic_dma_busy.
  */
-static void dshot_stop_input_capture(void) {
+static void dshot_stop_input_capture(dshot_motor_t *m) {
+    const dshot_port_t *port = m->port;
+
     /* Disable DMA */
-    DSHOT_TIMER->DIER &= ~TIM_DIER_CC1DE;
-    DSHOT_IC_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+    port->timer->DIER &= ~(TIM_DIER_CC1DE << (port->channel - 1));
+    port->ic_stream->CR &= ~DMA_SxCR_EN;
 
     /* Calculate how many edges we captured */
-    ic_edge_count = DSHOT_IC_BUFFER_SIZE - DSHOT_IC_DMA_STREAM->NDTR;
+    m->ic_edge_count = DSHOT_IC_BUFFER_SIZE - port->ic_stream->NDTR;
 }
 
 /**
- * @brief Send throttle command to ESC
+ * @brief Point the shared compare channel at the soonest armed deadline
+ *
+ * The flag is cleared and the interrupt enabled before the compare value
+ * is written, so a match right after the write is never wiped. A target
+ * the counter has already passed (short delays, late arming) would only
+ * match again after the 32-bit wrap; the event is then generated by
+ * software instead. Call with DSHOT_RX_TIMER_IRQ_PRIORITY masked or from
+ * that priority.
  */
-void dshot_send_throttle(uint16_t throttle) {
-    if (dshot_state != DSHOT_STATE_IDLE) {
-        return;  /* Busy */
+static void dshot_rx_timer_program(void) {
+    uint32_t now = DSHOT_RX_TIMER->CNT;
+    uint32_t target = 0;
+    int32_t soonest = INT32_MAX;
+    bool any = false;
+
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        const dshot_motor_t *m = &dshot_motors[i];
+        int32_t remaining = (int32_t)(m->rx_deadline - now);
+
+        if (m->rx_armed && remaining < soonest) {
+            soonest = remaining;
+            target = m->rx_deadline;
+            any = true;
+        }
+    }
+
+    if (!any) {
+        DSHOT_RX_TIMER->DIER &= ~TIM_DIER_CC1IE;
+        return;
+    }
+
+    DSHOT_RX_TIMER->SR = ~TIM_SR_CC1IF;
+    DSHOT_RX_TIMER->DIER |= TIM_DIER_CC1IE;
+    DSHOT_RX_TIMER->CCR1 = target;
+    if ((int32_t)(DSHOT_RX_TIMER->CNT - target) >= 0) {
+        DSHOT_RX_TIMER->EGR = TIM_EGR_CC1G;
+    }
+}
+
+/**
+ * @brief Raise a receive window event delay_us from now
+ */
+static void dshot_rx_timer_arm(uint8_t motor, uint32_t delay_us) {
+    dshot_motor_t *m = &dshot_motors[motor];
+
+    m->rx_deadline = DSHOT_RX_TIMER->CNT + delay_us * DSHOT_RX_TICKS_PER_US;
+    m->rx_armed = true;
+    dshot_rx_timer_program();
+}
+
+/**
+ * @brief Cancel a pending receive window event
+ *
+ * Only the motor's deadline is dropped (a single store, safe from any
+ * context); a compare still set for it raises one interrupt that finds
+ * nothing due and moves on to the next deadline.
+ */
+static void dshot_rx_timer_disarm(uint8_t motor) {
+    dshot_motors[motor].rx_armed = false;
+}
+
+/**
+ * @brief Encode a packet into the back buffer
+ *
+ * The back buffer is never read by DMA, so this is safe in any state.
+ * back_ready is dropped while encoding so a concurrent dshot_arm_frame()
+ * (e.g. from a scheduler interrupt) never sends a half-written frame.
+ */
+static void dshot_prepare_frame(dshot_motor_t *m, uint16_t packet, bool request_telemetry) {
+    m->back_ready = false;
+    dshot_encode_frame(m->dma_buffer[m->front ^ 1], &m->timing, packet, 1);
+    m->back_telemetry = request_telemetry;
+    m->back_ready = true;
+}
+
+/**
+ * @brief Flip to the prepared buffer and start its DMA transfer
+ *
+ * The channel is already in output mode whenever the motor is IDLE, so
+ * only the stream has to be armed. The stream is known to be disabled
+ * because its previous transfer-complete interrupt cleared tx_dma_busy.
+ *
+ * @return Send status
+ */
+static dshot_send_status_t dshot_arm_frame(dshot_motor_t *m) {
+    const dshot_port_t *port = m->port;
+    DMA_Stream_TypeDef *stream = port->tx_stream;
+
+    if (!m->back_ready) {
+        return DSHOT_SEND_DROPPED;
+    }
+    if (m->state != DSHOT_STATE_IDLE || m->tx_dma_busy || m->ic_dma_busy) {
+        return DSHOT_SEND_BUSY;
+    }
+
+    m->front ^= 1;
+    m->back_ready = false;
+    m->state = DSHOT_STATE_SENDING;
+    m->tx_dma_busy = true;
+    if (m->back_telemetry) {
+        m->telemetry.frame_count++;
+    }
+
+    /* Clear DMA flags and start */
+    dshot_dma_clear_flags(port->dma, port->tx_stream_index);
+
+    stream->CR = ((uint32_t)port->tx_dma_channel << 25) |  /* Channel selection */
+                 (2 << 16) |  /* Memory data size: 32-bit */
+                 (2 << 13) |  /* Peripheral data size: 32-bit */
+                 (1 << 10) |  /* Memory increment mode */
+                 (1 << 6) |   /* Direction: Memory to peripheral */
+                 (1 << 4);    /* Transfer complete interrupt enable */
+    stream->PAR = (uint32_t)m->ccr;
+    stream->M0AR = (uint32_t)m->dma_buffer[m->front];
+    stream->NDTR = DSHOT_FRAME_SIZE + 1;
+    stream->CR |= DMA_SxCR_EN;
+    m->times.sent = DWT->CYCCNT;
+
+    return DSHOT_SEND_QUEUED;
+}
+
+/**
+ * @brief Change the DShot protocol speed at runtime
+ */
+bool dshot_set_speed(uint16_t speed_kbit) {
+    if (speed_kbit != 150 && speed_kbit != 300 && speed_kbit != 600 && speed_kbit != 1200) {
+        return false;
+    }
+
+    if (burst_busy) {
+        return false;
+    }
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        if (dshot_motors[i].state != DSHOT_STATE_IDLE) {
+            return false;
+        }
+    }
+
+    dshot_speed = speed_kbit;
+
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        dshot_motor_t *m = &dshot_motors[i];
+
+        dshot_timing_init(&m->timing, m->port->timer_clock_hz, speed_kbit);
+        dshot_edge_table_init(&m->edge_table, m->timing.telem_bit);
+        m->dma_buffer[0][DSHOT_FRAME_SIZE] = m->timing.period;
+        m->dma_buffer[1][DSHOT_FRAME_SIZE] = m->timing.period;
+        m->back_ready = false;  /* Prepared frame used the old duty values */
+        if (!burst_active || m->port->timer != dshot_burst_port.timer) {
+            dshot_timer_reload(m->port->timer, &m->timing);
+        }
+    }
+
+    dshot_timing_init(&burst_timing, dshot_burst_port.timer_clock_hz, speed_kbit);
+    if (burst_active) {
+        dshot_timer_reload(dshot_burst_port.timer, &burst_timing);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get the current DShot protocol speed
+ */
+uint16_t dshot_get_speed(void) {
+    return dshot_speed;
+}
+
+/**
+ * @brief Encode a throttle frame ahead of time
+ */
+void dshot_motor_prepare_throttle(uint8_t motor, uint16_t throttle) {
+    if (motor >= DSHOT_MOTOR_COUNT) {
+        return;
     }
 
     /* Clamp throttle value */
@@ -239,319 +602,670 @@ void dshot_send_throttle(uint16_t throttle) {
     }
 
     /* Create packet with telemetry request bit SET for bidirectional DShot */
-    uint16_t packet = dshot_create_packet(throttle, true);
-    dshot_encode_dma_buffer(packet);
+    dshot_prepare_frame(&dshot_motors[motor], dshot_create_packet(throttle, true), true);
+}
 
-    /* Ensure we're in output mode */
-    dshot_switch_to_output();
+/**
+ * @brief Encode a special command frame ahead of time
+ */
+void dshot_motor_prepare_command(uint8_t motor, uint8_t command) {
+    if (motor >= DSHOT_MOTOR_COUNT || command > DSHOT_CMD_MAX) {
+        return;
+    }
 
-    /* Start DMA transfer */
-    dshot_state = DSHOT_STATE_SENDING;
-    telemetry.frame_count++;
+    /* Commands don't request telemetry */
+    dshot_prepare_frame(&dshot_motors[motor], dshot_create_packet(command, false), false);
+}
 
-    /* Clear DMA flags and start */
-    DMA2->LIFCR = DMA_LIFCR_CTCIF1 | DMA_LIFCR_CHTIF1 | DMA_LIFCR_CTEIF1 | DMA_LIFCR_CDMEIF1 | DMA_LIFCR_CFEIF1;
+/**
+ * @brief Send the most recently prepared frame
+ */
+dshot_send_status_t dshot_motor_send_prepared(uint8_t motor) {
+    if (motor >= DSHOT_MOTOR_COUNT) {
+        return DSHOT_SEND_DROPPED;
+    }
 
-    DSHOT_DMA_STREAM->CR &= ~DMA_SxCR_EN;
-    while (DSHOT_DMA_STREAM->CR & DMA_SxCR_EN);
+    return dshot_arm_frame(&dshot_motors[motor]);
+}
 
-    DSHOT_DMA_STREAM->NDTR = DSHOT_FRAME_SIZE + 1;
-    DSHOT_DMA_STREAM->CR |= DMA_SxCR_EN;
+/**
+ * @brief Send throttle command to ESC
+ */
+dshot_send_status_t dshot_motor_send_throttle(uint8_t motor, uint16_t throttle) {
+    dshot_motor_prepare_throttle(motor, throttle);
+    return dshot_motor_send_prepared(motor);
 }
 
 /**
  * @brief Send special DShot command
  */
-void dshot_send_command(uint8_t command) {
-    if (command <= DSHOT_CMD_MAX) {
-        /* Commands don't request telemetry */
-        if (dshot_state != DSHOT_STATE_IDLE) {
-            return;
-        }
+dshot_send_status_t dshot_motor_send_command(uint8_t motor, uint8_t command) {
+    if (motor >= DSHOT_MOTOR_COUNT || command > DSHOT_CMD_MAX) {
+        return DSHOT_SEND_DROPPED;
+    }
 
-        uint16_t packet = dshot_create_packet(command, false);
-        dshot_encode_dma_buffer(packet);
+    dshot_motor_prepare_command(motor, command);
+    return dshot_motor_send_prepared(motor);
+}
 
-        dshot_switch_to_output();
-        dshot_state = DSHOT_STATE_SENDING;
+/**
+ * @brief Check if a motor is ready to send
+ */
+bool dshot_motor_ready(uint8_t motor) {
+    return motor < DSHOT_MOTOR_COUNT && dshot_motors[motor].state == DSHOT_STATE_IDLE &&
+           !dshot_motors[motor].tx_dma_busy && !dshot_motors[motor].ic_dma_busy;
+}
 
-        DMA2->LIFCR = DMA_LIFCR_CTCIF1 | DMA_LIFCR_CHTIF1 | DMA_LIFCR_CTEIF1 | DMA_LIFCR_CDMEIF1 | DMA_LIFCR_CFEIF1;
+/**
+ * @brief Get state of one motor
+ */
+dshot_state_t dshot_motor_get_state(uint8_t motor) {
+    if (motor >= DSHOT_MOTOR_COUNT) {
+        return DSHOT_STATE_IDLE;
+    }
+    return dshot_motors[motor].state;
+}
 
-        DSHOT_DMA_STREAM->CR &= ~DMA_SxCR_EN;
-        while (DSHOT_DMA_STREAM->CR & DMA_SxCR_EN);
+/**
+ * @brief Get telemetry data of one motor
+ */
+dshot_telemetry_t* dshot_motor_get_telemetry(uint8_t motor) {
+    if (motor >= DSHOT_MOTOR_COUNT) {
+        return NULL;
+    }
+    return &dshot_motors[motor].telemetry;
+}
 
-        DSHOT_DMA_STREAM->NDTR = DSHOT_FRAME_SIZE + 1;
-        DSHOT_DMA_STREAM->CR |= DMA_SxCR_EN;
+/**
+ * @brief Configure the eRPM filter of every motor
+ */
+bool dshot_set_erpm_filter(uint8_t order, uint16_t cutoff_hz, uint16_t rate_hz) {
+    dshot_erpm_filter_config_t config;
+
+    if (!dshot_erpm_filter_config(&config, order, cutoff_hz, rate_hz)) {
+        return false;
     }
+
+    /* Both fields change together for the receive interrupts */
+    __disable_irq();
+    erpm_filter_config = config;
+    __enable_irq();
+    return true;
+}
+
+/**
+ * @brief Current eRPM filter coefficients
+ */
+const dshot_erpm_filter_config_t* dshot_get_erpm_filter(void) {
+    return &erpm_filter_config;
+}
+
+/**
+ * @brief Current time in telemetry time base counts
+ */
+uint32_t dshot_time_now(void) {
+    return DWT->CYCCNT;
 }
 
 /**
- * @brief Check if DShot is ready to send
+ * @brief Age of the last valid telemetry sample
+ */
+uint32_t dshot_telem_age_us(const dshot_telemetry_t *telem) {
+    if (telem->success_count == 0) {
+        return UINT32_MAX;
+    }
+    return (DWT->CYCCNT - telem->last_update) / DSHOT_TIME_TICKS_PER_US;
+}
+
+/**
+ * @brief Command to telemetry latency of the latest reception
+ */
+uint32_t dshot_telem_latency_us(const dshot_telemetry_t *telem) {
+    return (telem->times.decoded - telem->times.sent) / DSHOT_TIME_TICKS_PER_US;
+}
+
+/**
+ * @brief Copy a consistent telemetry record of one motor
+ */
+bool dshot_motor_read_telemetry(uint8_t motor, dshot_telemetry_t *out) {
+    if (motor >= DSHOT_MOTOR_COUNT) {
+        return false;
+    }
+
+    dshot_motor_t *m = &dshot_motors[motor];
+    uint32_t previous = out->success_count;
+    uint32_t seq;
+
+    do {
+        seq = m->telem_seq;
+        __DMB();
+        *out = m->telem_pub[seq & 1];
+        __DMB();
+    } while (seq != m->telem_seq);
+
+    return out->valid && out->success_count != previous;
+}
+
+/**
+ * @brief Check if new telemetry available for one motor
+ */
+bool dshot_motor_telemetry_available(uint8_t motor) {
+    if (motor >= DSHOT_MOTOR_COUNT) {
+        return false;
+    }
+
+    dshot_motor_t *m = &dshot_motors[motor];
+
+    /* The decode interrupt sets the flag: test and clear together */
+    __disable_irq();
+    bool available = m->new_telemetry_available;
+    m->new_telemetry_available = false;
+    __enable_irq();
+    return available;
+}
+
+/**
+ * @brief Send throttle command to motor 0
+ */
+dshot_send_status_t dshot_send_throttle(uint16_t throttle) {
+    return dshot_motor_send_throttle(0, throttle);
+}
+
+/**
+ * @brief Send special DShot command to motor 0
+ */
+dshot_send_status_t dshot_send_command(uint8_t command) {
+    return dshot_motor_send_command(0, command);
+}
+
+/**
+ * @brief Check if motor 0 is ready to send
  */
 bool dshot_ready(void) {
-    return dshot_state == DSHOT_STATE_IDLE;
+    return dshot_motor_ready(0);
 }
 
 /**
- * @brief Get current state
+ * @brief Get current state of motor 0
  */
 dshot_state_t dshot_get_state(void) {
-    return dshot_state;
+    return dshot_motor_get_state(0);
 }
 
 /**
- * @brief Get telemetry data
+ * @brief Get telemetry data of motor 0
  */
 dshot_telemetry_t* dshot_get_telemetry(void) {
-    return &telemetry;
+    return dshot_motor_get_telemetry(0);
 }
 
 /**
- * @brief Check if new telemetry available
+ * @brief Check if new telemetry available for motor 0
  */
 bool dshot_telemetry_available(void) {
-    bool available = new_telemetry_available;
-    new_telemetry_available = false;
-    return available;
+    return dshot_motor_telemetry_available(0);
 }
 
 /**
- * @brief Create DShot packet with CRC
+ * @brief Initialize burst output on CH1-CH4 of the burst timer
+ *
+ * The update DMA request of the timer feeds TIMx->DMAR. With DCR set to
+ * start at CCR1 with a burst length of 4, every update event moves four
+ * words from the interleaved buffer into CCR1..CCR4.
  */
-static uint16_t dshot_create_packet(uint16_t value, bool request_telemetry) {
-    /* Packet format: [11-bit value][1-bit telemetry][4-bit CRC] */
-    uint16_t packet = (value << 1) | (request_telemetry ? 1 : 0);
+bool dshot_burst_init(void) {
+    const dshot_burst_port_t *bp = &dshot_burst_port;
+    TIM_TypeDef *tim = bp->timer;
+
+    /* Enable clocks */
+    RCC->AHB1ENR |= bp->rcc_ahb1enr;
+    RCC->APB1ENR |= bp->rcc_apb1enr;
+    RCC->APB2ENR |= bp->rcc_apb2enr;
+
+    /* Release motors that share the burst timer */
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        dshot_motor_t *m = &dshot_motors[i];
+        if (dshot_ports[i].timer != tim) {
+            continue;
+        }
+        tim->DIER &= ~(TIM_DIER_CC1DE << (dshot_ports[i].channel - 1));
+        dshot_ports[i].tx_stream->CR &= ~DMA_SxCR_EN;
+        dshot_ports[i].ic_stream->CR &= ~DMA_SxCR_EN;
+        dshot_rx_timer_disarm(i);
+        m->tx_dma_busy = false;
+        m->ic_dma_busy = false;
+        m->state = DSHOT_STATE_IDLE;
+    }
+
+    dshot_timing_init(&burst_timing, bp->timer_clock_hz, dshot_speed);
+
+    /* GPIO: Alternate function mode for all four timer outputs */
+    for (int ch = 0; ch < DSHOT_BURST_MOTORS; ch++) {
+        dshot_gpio_config_af(bp->gpio, bp->pins[ch], bp->af);
+    }
+
+    /* Configure Timer for four-channel PWM */
+    tim->CR1 = 0;                                  /* Disable timer */
+    tim->PSC = 0;                                  /* No prescaler */
+    tim->ARR = burst_timing.period - 1;            /* Auto-reload value */
+
+    /* PWM mode 1 with preload on CH1-CH4 */
+    tim->CCMR1 = (6 << 4) | TIM_CCMR1_OC1PE | (6 << 12) | TIM_CCMR1_OC2PE;
+    tim->CCMR2 = (6 << 4) | TIM_CCMR2_OC3PE | (6 << 12) | TIM_CCMR2_OC4PE;
+
+    /* Active high, all outputs enabled */
+    tim->CCER = TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E | TIM_CCER_CC4E;
+
+    /* Idle high on every line */
+    tim->CCR1 = burst_timing.period;
+    tim->CCR2 = burst_timing.period;
+    tim->CCR3 = burst_timing.period;
+    tim->CCR4 = burst_timing.period;
+
+    tim->BDTR |= TIM_BDTR_MOE;                     /* Main output enable */
 
-    /* Calculate 4-bit CRC (XOR of nibbles) */
-    uint16_t crc = (packet ^ (packet >> 4) ^ (packet >> 8)) & 0x0F;
+    /* DMA burst: start at CCR1, 4 transfers per update event */
+    tim->DCR = (3 << 8) |                          /* DBL = 4 transfers */
+               (0x34 / 4);                         /* DBA = CCR1 (offset 0x34) */
+    tim->DIER |= TIM_DIER_UDE;                     /* DMA request on update */
 
-    return (packet << 4) | crc;
+    /* Configure burst DMA stream (Memory to Peripheral) */
+    bp->stream->CR = 0;
+    while (bp->stream->CR & DMA_SxCR_EN);
+
+    bp->stream->CR = ((uint32_t)bp->dma_channel << 25) |  /* Channel selection */
+                     (2 << 16) |  /* Memory data size: 32-bit */
+                     (2 << 13) |  /* Peripheral data size: 32-bit */
+                     (1 << 10) |  /* Memory increment mode */
+                     (1 << 6) |   /* Direction: Memory to peripheral */
+                     (1 << 4);    /* Transfer complete interrupt enable */
+
+    bp->stream->PAR = (uint32_t)&tim->DMAR;
+    bp->stream->M0AR = (uint32_t)dshot_burst_buffer;
+    bp->stream->NDTR = (DSHOT_FRAME_SIZE + 1) * DSHOT_BURST_MOTORS;
+
+    NVIC_SetPriority(bp->irq, DSHOT_DMA_IRQ_PRIORITY);
+    NVIC_EnableIRQ(bp->irq);
+
+    /* Enable timer */
+    tim->CR1 |= TIM_CR1_CEN;
+
+    burst_busy = false;
+    burst_active = true;
+
+    return true;
 }
 
 /**
- * @brief Encode DShot packet into DMA buffer
- *
- * For bidirectional DShot, the signal is INVERTED:
- * - Idle state is HIGH
- * - '0' bit: 62.5% high, 37.5% low
- * - '1' bit: 25% high, 75% low
- *
- * Using inverted PWM mode to achieve this.
+ * @brief Send one frame to each burst motor in a single DMA transfer
  */
-static void dshot_encode_dma_buffer(uint16_t packet) {
-    /* For inverted DShot (bidirectional), we invert the duty cycles */
-    uint16_t bit_0_duty = DSHOT_TIMER_PERIOD - DSHOT_BIT_0_DUTY;  /* ~62.5% for '0' */
-    uint16_t bit_1_duty = DSHOT_TIMER_PERIOD - DSHOT_BIT_1_DUTY;  /* ~25% for '1' */
+dshot_send_status_t dshot_burst_send(const uint16_t throttles[DSHOT_BURST_MOTORS]) {
+    const dshot_burst_port_t *bp = &dshot_burst_port;
 
-    for (int i = 0; i < DSHOT_FRAME_SIZE; i++) {
-        if (packet & 0x8000) {
-            dshot_dma_buffer[i] = bit_1_duty;
-        } else {
-            dshot_dma_buffer[i] = bit_0_duty;
+    if (!burst_active) {
+        return DSHOT_SEND_DROPPED;
+    }
+    if (burst_busy) {
+        return DSHOT_SEND_BUSY;  /* Previous burst still on the wire */
+    }
+
+    for (int ch = 0; ch < DSHOT_BURST_MOTORS; ch++) {
+        uint16_t value = throttles[ch];
+
+        /* Clamp throttle value */
+        if (value > DSHOT_THROTTLE_MAX) {
+            value = DSHOT_THROTTLE_MAX;
         }
-        packet <<= 1;
+
+        /* No receiver in burst mode, so telemetry is never requested */
+        uint16_t packet = dshot_create_packet(value, false);
+        dshot_encode_frame(&dshot_burst_buffer[ch], &burst_timing, packet, DSHOT_BURST_MOTORS);
     }
-    /* Trailing zero to end the frame cleanly */
-    dshot_dma_buffer[DSHOT_FRAME_SIZE] = DSHOT_TIMER_PERIOD;  /* Full high for idle */
+
+    burst_busy = true;
+
+    /* Clear DMA flags and start */
+    dshot_dma_clear_flags(bp->dma, bp->stream_index);
+
+    /* The stream stopped itself at the end of the previous burst */
+    bp->stream->NDTR = (DSHOT_FRAME_SIZE + 1) * DSHOT_BURST_MOTORS;
+    bp->stream->CR |= DMA_SxCR_EN;
+
+    return DSHOT_SEND_QUEUED;
+}
+
+/**
+ * @brief Check if the previous burst transfer has completed
+ */
+bool dshot_burst_ready(void) {
+    return !burst_busy;
 }
 
 /**
  * @brief Process bidirectional telemetry state machine
  */
 void dshot_update(void) {
-    tick_counter++;
-
-    switch (dshot_state) {
-        case DSHOT_STATE_WAIT_TELEM:
-            /* Wait for response window, then start capture */
-            if ((tick_counter - telem_start_time) >= 1) {  /* ~1ms tick, adjust as needed */
-                dshot_switch_to_input();
-                dshot_start_input_capture();
-                dshot_state = DSHOT_STATE_RECEIVING;
-            }
-            break;
-
-        case DSHOT_STATE_RECEIVING:
-            /* Check if we've captured enough edges or timed out */
-            {
-                uint8_t captured = DSHOT_IC_BUFFER_SIZE - DSHOT_IC_DMA_STREAM->NDTR;
-                if (captured >= 20 || (tick_counter - telem_start_time) >= 2) {
-                    dshot_stop_input_capture();
-                    dshot_state = DSHOT_STATE_PROCESSING;
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        dshot_motor_t *m = &dshot_motors[i];
+
+        switch (m->state) {
+            case DSHOT_STATE_PROCESSING:
+                /* Decode the captured telemetry */
+                dshot_process_capture(m);
+                break;
+
+            case DSHOT_STATE_WAIT_TELEM:
+            case DSHOT_STATE_RECEIVING:
+                if (DWT->CYCCNT - m->times.sent > DSHOT_RX_WATCHDOG_US * DSHOT_TIME_TICKS_PER_US) {
+                    dshot_rx_watchdog(m);
                 }
-            }
-            break;
-
-        case DSHOT_STATE_PROCESSING:
-            /* Decode the captured telemetry */
-            if (dshot_decode_telemetry()) {
-                telemetry.valid = true;
-                telemetry.success_count++;
-                telemetry.last_update = tick_counter;
-                new_telemetry_available = true;
-            } else {
-                telemetry.error_count++;
-            }
-            dshot_switch_to_output();
-            dshot_state = DSHOT_STATE_IDLE;
-            break;
+                break;
 
-        default:
-            break;
+            default:
+                break;
+        }
     }
 }
 
 /**
- * @brief Decode GCR value to nibbles
+ * @brief Recover a motor whose receive window event never arrived
  *
- * GCR encoding uses 5 bits to represent 4 bits, ensuring no long runs
- * of same bits which helps with signal integrity.
+ * Ends the reception as the window event would have: a running capture
+ * is stopped and decoded, a window that never opened is published as a
+ * timeout. Runs with interrupts off so it cannot race a late event.
  */
-static uint32_t dshot_decode_gcr(uint32_t gcr_value) {
-    uint32_t result = 0;
+static void dshot_rx_watchdog(dshot_motor_t *m) {
+    __disable_irq();
+
+    /* Re-check: the event may have arrived since dshot_update() looked */
+    if (DWT->CYCCNT - m->times.sent > DSHOT_RX_WATCHDOG_US * DSHOT_TIME_TICKS_PER_US) {
+        if (m->state == DSHOT_STATE_RECEIVING) {
+            dshot_capture_done(m);
+        } else if (m->state == DSHOT_STATE_WAIT_TELEM) {
+            dshot_rx_timer_disarm(m - dshot_motors);
+            m->ic_edge_count = 0;
+            m->times.capture_start = DWT->CYCCNT;
+            m->times.capture_end = m->times.capture_start;
+            dshot_process_capture(m);
+        }
+    }
+
+    __enable_irq();
+}
 
-    /* Extract 4 nibbles from 20 GCR bits (MSB first) */
-    for (int i = 0; i < 4; i++) {
-        uint8_t gcr_symbol = (gcr_value >> (15 - i * 5)) & 0x1F;
-        uint8_t nibble = gcr_decode_table[gcr_symbol];
+/**
+ * @brief End a telemetry capture
+ *
+ * Called from whichever interrupt ends the capture (window timeout on
+ * DSHOT_RX_TIMER, or input capture buffer full). With
+ * DSHOT_DECODE_IN_ISR the response is decoded and published right here
+ * and the cost is recorded in DWT cycles; otherwise it is left for the
+ * next dshot_update().
+ */
+static void dshot_capture_done(dshot_motor_t *m) {
+    uint32_t start = DWT->CYCCNT;
 
-        if (nibble == 0xFF) {
-            return 0xFFFFFFFF;  /* Invalid GCR symbol */
-        }
+    m->times.capture_end = start;
+    dshot_rx_timer_disarm(m - dshot_motors);
 
-        result = (result << 4) | nibble;
+#if DSHOT_DECODE_IN_ISR
+
+    dshot_stop_input_capture(m);
+    dshot_process_capture(m);
+
+    uint32_t cycles = DWT->CYCCNT - start;
+    decode_last_cycles = cycles;
+    if (cycles > decode_max_cycles) {
+        decode_max_cycles = cycles;
     }
+    decode_total_cycles += cycles;
+    decode_count++;
+#else
+    dshot_stop_input_capture(m);
+    m->state = DSHOT_STATE_PROCESSING;
+#endif
+}
 
-    return result;
+/**
+ * @brief Decode a finished capture, publish it and return to output
+ */
+static void dshot_process_capture(dshot_motor_t *m) {
+    uint32_t rx_scale = m->rx_scale;   /* Estimate this capture is decoded with */
+    dshot_telem_result_t result = dshot_decode_telemetry(m);
+
+#if DSHOT_CAPTURE_LOG
+    dshot_capture_record(m - dshot_motors, m->ic_buffer, m->ic_edge_count,
+                         m->timing.telem_bit, rx_scale, result);
+#else
+    (void)rx_scale;
+#endif
+    dshot_telem_account(&m->telemetry, result);
+    bool fresh = dshot_erpm_sample(&m->telemetry, result,
+                                   DSHOT_ERPM_FILTER ? &m->erpm_filter : NULL, &erpm_filter_config,
+                                   DSHOT_ERPM_MOTION ? &m->erpm_motion : NULL,
+                                   m->times.capture_end, DSHOT_TIME_CLOCK_HZ);
+    m->times.decoded = DWT->CYCCNT;
+    m->telemetry.times = m->times;
+    if (fresh) {
+        m->telemetry.last_update = m->times.decoded;
+    }
+    dshot_publish_telemetry(m);
+    if (fresh) {
+        m->new_telemetry_available = true;
+    }
+    dshot_switch_to_output(m);
+    m->state = DSHOT_STATE_IDLE;
+}
+
+/**
+ * @brief Publish the working copy to both reader copies
+ *
+ * Sequence counter with two copies: while the count is odd copy 0 is
+ * being written and readers take copy 1, while it is even readers take
+ * copy 0. A reader that interrupts this function therefore always finds
+ * a complete copy and never has to wait for it to return.
+ */
+static void dshot_publish_telemetry(dshot_motor_t *m) {
+    m->telem_seq++;
+    __DMB();
+    m->telem_pub[0] = m->telemetry;
+    __DMB();
+    m->telem_seq++;
+    __DMB();
+    m->telem_pub[1] = m->telemetry;
+}
+
+/**
+ * @brief Read telemetry decode cycle statistics
+ */
+void dshot_get_decode_stats(dshot_decode_stats_t *stats) {
+    /* Snapshot without tearing against the capture interrupt */
+    __disable_irq();
+    stats->count = decode_count;
+    stats->last_cycles = decode_last_cycles;
+    stats->max_cycles = decode_max_cycles;
+    stats->avg_cycles = decode_count ? (uint32_t)(decode_total_cycles / decode_count) : 0;
+    __enable_irq();
+}
+
+/**
+ * @brief Reset telemetry decode cycle statistics
+ */
+void dshot_reset_decode_stats(void) {
+    __disable_irq();
+    decode_count = 0;
+    decode_last_cycles = 0;
+    decode_max_cycles = 0;
+    decode_total_cycles = 0;
+    __enable_irq();
 }
 
 /**
  * @brief Decode telemetry from captured edges
  *
- * The ESC sends a 21-bit GCR-encoded response:
- * - 20 bits of GCR data (4 nibbles × 5 bits each)
- * - 1 stop/marker bit
+ * The ESC sends a 21-bit response: a start bit followed by 20 bits of
+ * transition-encoded GCR data (4 nibbles × 5 bits each). Bits after the
+ * last captured edge are idle and padded here.
  *
  * The decoded 16 bits contain:
- * - Bits 15-4: 12-bit eRPM period in microseconds
- * - Bits 3-0: 4-bit CRC
+ * - Bits 15-4: eRPM period, 3-bit exponent + 9-bit mantissa (us)
+ * - Bits 3-0: 4-bit inverted CRC
  */
-static bool dshot_decode_telemetry(void) {
-    if (ic_edge_count < 2) {
-        return false;  /* Not enough edges */
+static dshot_telem_result_t dshot_decode_telemetry(dshot_motor_t *m) {
+    if (m->ic_edge_count == 0) {
+        return DSHOT_TELEM_ERR_TIMEOUT;  /* No response in the window */
+    }
+    if (m->ic_edge_count < DSHOT_TELEM_MIN_EDGES) {
+        return DSHOT_TELEM_ERR_EDGES;  /* Not enough edges */
     }
 
-    /* Calculate bit period from captured edges
-     * The response is at 5/4 the command rate (750kbps for DShot600)
-     * Bit time = 168MHz / 750000 = 224 timer ticks
-     */
-    uint16_t bit_period = (TIMER_CLOCK_HZ / DSHOT_TELEM_BITRATE);
-    uint16_t half_bit = bit_period / 2;
-
-    /* Decode edges to bits using timing analysis */
-    uint32_t gcr_bits = 0;
-    uint8_t bit_count = 0;
-    uint8_t current_level = 1;  /* Start high (idle) */
-
-    for (int i = 1; i < ic_edge_count && bit_count < 21; i++) {
-        /* Calculate time between edges */
-        uint16_t delta;
-        if (dshot_ic_buffer[i] >= dshot_ic_buffer[i-1]) {
-            delta = dshot_ic_buffer[i] - dshot_ic_buffer[i-1];
-        } else {
-            /* Timer wrapped */
-            delta = (0xFFFF - dshot_ic_buffer[i-1]) + dshot_ic_buffer[i] + 1;
-        }
+    /* Nominal bit period: 168MHz / 750000 = 224 timer ticks for DShot600
+     * (recomputed by dshot_set_speed()), corrected by the running estimate
+     * of this ESC's clock */
+    uint32_t gcr_bits;
+    uint8_t bit_count = dshot_edges_to_bits_table(&m->edge_table, m->ic_buffer,
+                                                  m->ic_edge_count, m->rx_scale, &gcr_bits);
 
-        /* Determine how many bits this edge represents */
-        uint8_t num_bits = (delta + half_bit) / bit_period;
-        if (num_bits == 0) num_bits = 1;
-        if (num_bits > 5) num_bits = 5;  /* Limit to reasonable value */
+    if (bit_count < DSHOT_TELEM_MIN_BITS) {
+        return DSHOT_TELEM_ERR_BITS;  /* Not enough bits decoded */
+    }
 
-        /* Add bits to result */
-        for (int b = 0; b < num_bits && bit_count < 21; b++) {
-            gcr_bits = (gcr_bits << 1) | current_level;
-            bit_count++;
-        }
+    /* No edges after the last GCR '1': the line stays idle (0) */
+    gcr_bits <<= DSHOT_TELEM_FRAME_BITS - bit_count;
 
-        /* Toggle level after edge */
-        current_level ^= 1;
+    dshot_telem_result_t result = dshot_decode_gcr_frame(gcr_bits, &m->telemetry);
+    if (!DSHOT_TELEM_VALID(result)) {
+        return result;
     }
 
-    if (bit_count < 20) {
-        return false;  /* Not enough bits decoded */
-    }
+    /* Only frames that passed CRC (eRPM or EDT) refine the clock estimate */
+    m->rx_scale = dshot_rx_scale_update(&m->edge_table, m->ic_buffer,
+                                        m->ic_edge_count, m->rx_scale);
+    return result;
+}
 
-    /* Extract the 20 GCR bits (ignore the 21st marker bit) */
-    uint32_t gcr_value = (gcr_bits >> 1) & 0xFFFFF;
+/**
+ * @brief DMA stream interrupt dispatcher
+ *
+ * A stream may serve TX and input capture of the same motor, so the
+ * motor state decides which transfer just completed.
+ */
+void dshot_dma_irq_handler(DMA_Stream_TypeDef *stream) {
+    if (dshot_bb_dma_irq_handler(stream)) {
+        return;
+    }
 
-    /* Decode GCR to get 16-bit value */
-    uint32_t decoded = dshot_decode_gcr(gcr_value);
-    if (decoded == 0xFFFFFFFF) {
-        return false;  /* GCR decode error */
+    if (stream == dshot_burst_port.stream) {
+        /* Clear interrupt flag */
+        dshot_dma_clear_flags(dshot_burst_port.dma, dshot_burst_port.stream_index);
+        if (!(stream->CR & DMA_SxCR_EN)) {
+            burst_busy = false;
+        }
+        return;
     }
 
-    /* Extract eRPM period (bits 15-4) and CRC (bits 3-0) */
-    uint16_t period = (decoded >> 4) & 0x0FFF;
-    uint8_t received_crc = decoded & 0x0F;
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        dshot_motor_t *m = &dshot_motors[i];
+        const dshot_port_t *port = &dshot_ports[i];
+
+        if (stream != port->tx_stream && stream != port->ic_stream) {
+            continue;
+        }
 
-    /* Verify CRC */
-    uint8_t calculated_crc = (~(decoded >> 4)) & 0x0F;
-    calculated_crc = (calculated_crc ^ (calculated_crc >> 4)) & 0x0F;
+        /* TC is raised once the stream has stopped (end of transfer, or
+         * after EN was cleared by software). This is the only place the
+         * busy flags are released. */
+        bool stopped = !(stream->CR & DMA_SxCR_EN);
 
-    /* Alternative CRC: XOR of nibbles */
-    uint16_t temp = decoded >> 4;
-    uint8_t crc_check = (temp ^ (temp >> 4) ^ (temp >> 8)) & 0x0F;
+        if (stream == port->tx_stream && m->state == DSHOT_STATE_SENDING) {
+            dshot_dma_clear_flags(port->dma, port->tx_stream_index);
+            m->tx_dma_busy = !stopped;
 
-    if (received_crc != crc_check) {
-        return false;  /* CRC mismatch */
+            /* Frame sent - open the receive window after the turnaround */
+            m->state = DSHOT_STATE_WAIT_TELEM;
+            dshot_rx_timer_arm(i, DSHOT_TELEM_DELAY_US);
+        } else if (stream == port->ic_stream && m->state == DSHOT_STATE_RECEIVING) {
+            dshot_dma_clear_flags(port->dma, port->ic_stream_index);
+            m->ic_dma_busy = !stopped;
+
+            /* Buffer full - can process telemetry */
+            dshot_capture_done(m);
+        } else {
+            /* Late TC, e.g. after a capture timeout disabled the stream */
+            if (stream == port->tx_stream) {
+                dshot_dma_clear_flags(port->dma, port->tx_stream_index);
+                m->tx_dma_busy = !stopped;
+            }
+            if (stream == port->ic_stream) {
+                dshot_dma_clear_flags(port->dma, port->ic_stream_index);
+                m->ic_dma_busy = !stopped;
+            }
+        }
     }
+}
 
-    /* Store telemetry data */
-    telemetry.period_us = period;
+/**
+ * @brief Receive window timer interrupt
+ *
+ * All motors share compare channel 1, set for the soonest deadline; every
+ * motor whose deadline has passed is served, then the channel moves on.
+ * First event (WAIT_TELEM): the turnaround has elapsed, switch the pin to
+ * input and start capturing. Second event (RECEIVING): the window is
+ * over, end the capture.
+ */
+void dshot_rx_timer_irq_handler(void) {
+    DSHOT_RX_TIMER->SR = ~TIM_SR_CC1IF;
 
-    /* Calculate eRPM from period
-     * period is in 1/16th microsecond units for EDT (extended telemetry)
-     * or microseconds for basic telemetry
-     *
-     * eRPM = 60,000,000 / period_us (for period in microseconds)
-     * Actual RPM = eRPM * 2 / motor_poles
-     */
-    if (period > 0) {
-        telemetry.erpm = 60000000UL / period;
-        telemetry.rpm = (telemetry.erpm * 2) / MOTOR_POLES;
-    } else {
-        telemetry.erpm = 0;
-        telemetry.rpm = 0;
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        dshot_motor_t *m = &dshot_motors[i];
+
+        if (!m->rx_armed || (int32_t)(DSHOT_RX_TIMER->CNT - m->rx_deadline) < 0) {
+            continue;
+        }
+        m->rx_armed = false;
+
+        if (m->state == DSHOT_STATE_WAIT_TELEM) {
+            if (m->ic_dma_busy) {
+                dshot_rx_timer_arm(i, 1);  /* Previous capture still stopping */
+                continue;
+            }
+            dshot_switch_to_input(m);
+            dshot_start_input_capture(m);
+            m->times.capture_start = DWT->CYCCNT;
+            m->state = DSHOT_STATE_RECEIVING;
+            dshot_rx_timer_arm(i, DSHOT_TELEM_WINDOW_US);
+        } else if (m->state == DSHOT_STATE_RECEIVING) {
+            dshot_capture_done(m);
+        }
     }
 
-    return true;
+    dshot_rx_timer_program();
+}
+
+/**
+ * @brief Receive window timer interrupt handler
+ */
+void TIM2_IRQHandler(void) {
+    dshot_rx_timer_irq_handler();
 }
 
 /**
- * @brief DMA transfer complete interrupt handler (TX)
+ * @brief DMA transfer complete interrupt handler (motor 0 TX)
  */
 void DMA2_Stream1_IRQHandler(void) {
-    /* Clear interrupt flag */
-    DMA2->LIFCR = DMA_LIFCR_CTCIF1;
+    dshot_dma_irq_handler(DMA2_Stream1);
+}
 
-    if (dshot_state == DSHOT_STATE_SENDING) {
-        /* Frame sent - wait briefly then start telemetry capture */
-        dshot_state = DSHOT_STATE_WAIT_TELEM;
-        telem_start_time = tick_counter;
-    }
+/**
+ * @brief DMA transfer complete interrupt handler (burst or bit-bang TX/RX)
+ */
+void DMA2_Stream5_IRQHandler(void) {
+    dshot_dma_irq_handler(DMA2_Stream5);
 }
 
 /**
- * @brief DMA transfer complete interrupt handler (RX/Input Capture)
+ * @brief DMA transfer complete interrupt handler (motor 0 RX/Input Capture)
  */
 void DMA2_Stream6_IRQHandler(void) {
-    /* Clear interrupt flag */
-    DMA2->HIFCR = DMA_HIFCR_CTCIF6;
-
-    /* Buffer full - can process telemetry */
-    if (dshot_state == DSHOT_STATE_RECEIVING) {
-        dshot_stop_input_capture();
-        dshot_state = DSHOT_STATE_PROCESSING;
-    }
+    dshot_dma_irq_handler(DMA2_Stream6);
 }
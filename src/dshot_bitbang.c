@@ -0,0 +1,393 @@
+/**
+ * @file dshot_bitbang.c
+ * @brief GPIO bit-banged DShot output via DMA to BSRR
+ *
+ * The slot timer runs at three update events per DShot bit. Each update
+ * requests one DMA word, which is written to GPIOx->BSRR. Because BSRR
+ * only touches the pins whose set/reset bits are 1, the other pins of
+ * the port are unaffected and all motors on the port switch together.
+ *
+ * For telemetry the same timer is retuned to the sampling rate and the
+ * stream is turned around to copy GPIOx->IDR into a sample buffer, so
+ * reception needs neither capture channels nor a second stream. Both
+ * directions access the GPIO port on AHB1, which is why the stream has
+ * to be on DMA2.
+ */
+
+#include <stddef.h>
+#include "dshot_bitbang.h"
+#include "dshot.h"
+#include "stm32f4xx.h"
+
+/* Board configuration - ADJUST FOR YOUR BOARD
+ *
+ * Default: four motors on PB6-PB9, TIM1 (APB2, 168MHz) slot timer,
+ * TIM1_UP on DMA2 Stream 5 channel 6. Only DMA2 reaches the GPIO ports,
+ * so the slot timer must be one whose update request maps to DMA2: TIM1,
+ * or TIM8 (STM32F405/407, TIM8_UP on DMA2 Stream 1 channel 7). TIM1 and
+ * DMA2 Stream 5 are also the default motor timer and burst stream, so
+ * the bit-bang port replaces those engines rather than running beside
+ * them.
+ */
+const dshot_bb_port_t dshot_bb_port = {
+    .gpio           = GPIOB,
+    .pins           = { 6, 7, 8, 9 },
+    .motor_count    = 4,
+    .timer          = TIM1,
+    .timer_clock_hz = TIMER_CLOCK_HZ,
+    .dma            = DMA2,
+    .stream         = DMA2_Stream5,
+    .stream_index   = 5,
+    .dma_channel    = 6,
+    .irq            = DMA2_Stream5_IRQn,
+    .rcc_ahb1enr    = RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_DMA2EN,
+    .rcc_apb1enr    = 0,
+    .rcc_apb2enr    = RCC_APB2ENR_TIM1EN,
+};
+
+#define BB_BUFFER_SIZE  (DSHOT_FRAME_SIZE * DSHOT_BB_SLOTS_PER_BIT + 1)  /* +1 for trailing idle */
+
+/* BSRR word table for one frame */
+static uint32_t bb_buffer[BB_BUFFER_SIZE];
+
+/* IDR samples of one telemetry window (all pins of the port) */
+static uint16_t bb_samples[DSHOT_BB_MAX_SAMPLES];
+
+static uint32_t bb_pin_mask = 0;        /* All motor pins on the port */
+static uint16_t bb_speed = 0;           /* Speed the timer values are computed for */
+static uint16_t bb_slot_arr = 0;        /* ARR for TX slots */
+static uint16_t bb_sample_arr = 0;      /* ARR for RX sampling */
+static uint16_t bb_sample_count = 0;    /* Samples per telemetry window */
+static uint32_t bb_samples_per_bit_q8 = 0;  /* Samples per telemetry bit, 8.8 fixed point */
+
+/* Port state (shared by all motors on the port) */
+static volatile dshot_state_t bb_state = DSHOT_STATE_IDLE;
+static bool bb_request_telemetry = false;
+static dshot_telem_times_t bb_times;    /* Current frame, shared by all motors */
+
+/* Telemetry per motor */
+static dshot_telemetry_t bb_telemetry[DSHOT_BB_MAX_MOTORS];
+static volatile bool bb_new_telemetry[DSHOT_BB_MAX_MOTORS];
+static dshot_erpm_filter_t bb_erpm_filter[DSHOT_BB_MAX_MOTORS];
+static dshot_erpm_motion_t bb_erpm_motion[DSHOT_BB_MAX_MOTORS];
+
+/**
+ * @brief Compute slot/sample timer values for the current protocol speed
+ */
+static void dshot_bb_timing_config(void) {
+    const dshot_bb_port_t *bb = &dshot_bb_port;
+    uint32_t clk = bb->timer_clock_hz;
+    uint32_t slot_rate = (uint32_t)dshot_get_speed() * 1000UL * DSHOT_BB_SLOTS_PER_BIT;
+    uint32_t telem_bitrate = (uint32_t)dshot_get_speed() * 1000UL * 5 / 4;
+    uint32_t sample_rate = telem_bitrate * DSHOT_BB_OVERSAMPLE;
+    uint32_t sample_ticks = (clk + sample_rate / 2) / sample_rate;
+    uint32_t window_samples;
+
+    bb_slot_arr = (clk + slot_rate / 2) / slot_rate - 1;
+    bb_sample_arr = sample_ticks - 1;
+
+    /* Decode with the rate actually produced by the rounded ARR */
+    bb_samples_per_bit_q8 = ((uint64_t)clk << 8) / ((uint64_t)sample_ticks * telem_bitrate);
+
+    window_samples = (uint64_t)(DSHOT_TELEM_DELAY_US + DSHOT_TELEM_WINDOW_US) * (clk / sample_ticks) / 1000000UL;
+    bb_sample_count = (window_samples > DSHOT_BB_MAX_SAMPLES) ? DSHOT_BB_MAX_SAMPLES : window_samples;
+
+    bb_speed = dshot_get_speed();
+}
+
+/**
+ * @brief Drive all motor pins as push-pull outputs, idle high
+ */
+static void dshot_bb_pins_output(void) {
+    const dshot_bb_port_t *bb = &dshot_bb_port;
+
+    bb->gpio->BSRR = bb_pin_mask;                          /* Idle high before enabling */
+    for (int i = 0; i < bb->motor_count; i++) {
+        uint8_t pin = bb->pins[i];
+
+        bb->gpio->PUPDR &= ~(3UL << (pin * 2));            /* No pull */
+        bb->gpio->MODER &= ~(3UL << (pin * 2));
+        bb->gpio->MODER |= (1UL << (pin * 2));             /* General purpose output */
+    }
+}
+
+/**
+ * @brief Release all motor pins to inputs with pull-up for telemetry
+ */
+static void dshot_bb_pins_input(void) {
+    const dshot_bb_port_t *bb = &dshot_bb_port;
+
+    for (int i = 0; i < bb->motor_count; i++) {
+        uint8_t pin = bb->pins[i];
+
+        bb->gpio->MODER &= ~(3UL << (pin * 2));            /* Input */
+        bb->gpio->PUPDR &= ~(3UL << (pin * 2));
+        bb->gpio->PUPDR |= (1UL << (pin * 2));             /* Pull-up for idle high */
+    }
+}
+
+/**
+ * @brief Program the stream and timer for frame output
+ */
+static void dshot_bb_start_tx(void) {
+    const dshot_bb_port_t *bb = &dshot_bb_port;
+    DMA_Stream_TypeDef *stream = bb->stream;
+
+    /* Only called while the port is idle or from the TC interrupt, i.e.
+     * after the stream has stopped itself; EN is never polled */
+    dshot_dma_clear_flags(bb->dma, bb->stream_index);
+
+    stream->CR = ((uint32_t)bb->dma_channel << 25) |  /* Channel selection */
+                 (2 << 16) |  /* Memory data size: 32-bit */
+                 (2 << 13) |  /* Peripheral data size: 32-bit */
+                 (1 << 10) |  /* Memory increment mode */
+                 (1 << 6) |   /* Direction: Memory to peripheral */
+                 (1 << 4);    /* Transfer complete interrupt enable */
+    stream->PAR = (uint32_t)&bb->gpio->BSRR;
+    stream->M0AR = (uint32_t)bb_buffer;
+    stream->NDTR = BB_BUFFER_SIZE;
+    stream->CR |= DMA_SxCR_EN;
+    bb_times.sent = dshot_time_now();
+
+    /* Restart the slot grid so the first word lands at t = 0 */
+    bb->timer->ARR = bb_slot_arr;
+    bb->timer->EGR = TIM_EGR_UG;
+}
+
+/**
+ * @brief Turn the stream around to sample IDR for one telemetry window
+ */
+static void dshot_bb_start_rx(void) {
+    const dshot_bb_port_t *bb = &dshot_bb_port;
+    DMA_Stream_TypeDef *stream = bb->stream;
+
+    dshot_bb_pins_input();
+
+    /* Called from the TX transfer-complete interrupt, after the stream has
+     * stopped itself; EN is never polled */
+    dshot_dma_clear_flags(bb->dma, bb->stream_index);
+
+    /* IDR is read through the DMA2 peripheral port like BSRR is written */
+    stream->CR = ((uint32_t)bb->dma_channel << 25) |  /* Channel selection */
+                 (1 << 16) |  /* Memory data size: 16-bit */
+                 (1 << 13) |  /* Peripheral data size: 16-bit */
+                 (1 << 10) |  /* Memory increment mode */
+                 (0 << 6) |   /* Direction: Peripheral to memory */
+                 (1 << 4);    /* Transfer complete interrupt enable */
+    stream->PAR = (uint32_t)&bb->gpio->IDR;
+    stream->M0AR = (uint32_t)bb_samples;
+    stream->NDTR = bb_sample_count;
+    stream->CR |= DMA_SxCR_EN;
+    bb_times.capture_start = dshot_time_now();
+
+    bb->timer->ARR = bb_sample_arr;
+    bb->timer->EGR = TIM_EGR_UG;
+}
+
+/**
+ * @brief Initialize the bit-bang port
+ */
+bool dshot_bb_init(void) {
+    const dshot_bb_port_t *bb = &dshot_bb_port;
+
+    if (bb->motor_count == 0 || bb->motor_count > DSHOT_BB_MAX_MOTORS) {
+        return false;
+    }
+    if (bb->dma != DMA2) {
+        return false;  /* DMA1 cannot reach the GPIO ports */
+    }
+
+    /* Enable clocks */
+    RCC->AHB1ENR |= bb->rcc_ahb1enr;
+    RCC->APB1ENR |= bb->rcc_apb1enr;
+    RCC->APB2ENR |= bb->rcc_apb2enr;
+
+    /* GPIO: push-pull outputs, idle high */
+    bb_pin_mask = 0;
+    for (int i = 0; i < bb->motor_count; i++) {
+        uint8_t pin = bb->pins[i];
+
+        bb_pin_mask |= (1UL << pin);
+        bb->gpio->OSPEEDR |= (3UL << (pin * 2));           /* Very high speed */
+        bb->gpio->OTYPER &= ~(1UL << pin);                 /* Push-pull */
+
+        dshot_telem_reset(&bb_telemetry[i]);
+        bb_new_telemetry[i] = false;
+        dshot_erpm_filter_reset(&bb_erpm_filter[i]);
+        dshot_erpm_motion_reset(&bb_erpm_motion[i]);
+    }
+    dshot_bb_pins_output();
+
+    dshot_bb_timing_config();
+
+    /* Configure slot timer; DMA requests are ignored while the stream is off */
+    bb->timer->CR1 = 0;                                    /* Disable timer */
+    bb->timer->PSC = 0;                                    /* No prescaler */
+    bb->timer->ARR = bb_slot_arr;
+    bb->timer->EGR = TIM_EGR_UG;                           /* Load ARR */
+    bb->timer->DIER = TIM_DIER_UDE;                        /* DMA request on update */
+    bb->timer->CR1 |= TIM_CR1_CEN;
+
+    bb->stream->CR = 0;
+    while (bb->stream->CR & DMA_SxCR_EN);
+
+    NVIC_SetPriority(bb->irq, DSHOT_DMA_IRQ_PRIORITY);
+    NVIC_EnableIRQ(bb->irq);
+
+    bb_state = DSHOT_STATE_IDLE;
+
+    return true;
+}
+
+/**
+ * @brief Send one frame to every motor on the port
+ */
+dshot_send_status_t dshot_bb_send(const uint16_t *values, bool request_telemetry) {
+    const dshot_bb_port_t *bb = &dshot_bb_port;
+    uint16_t packets[DSHOT_BB_MAX_MOTORS];
+
+    if (bb_pin_mask == 0) {
+        return DSHOT_SEND_DROPPED;  /* Not initialized */
+    }
+    if (bb_state != DSHOT_STATE_IDLE) {
+        return DSHOT_SEND_BUSY;  /* Previous frame or telemetry window still in progress */
+    }
+
+    if (bb_speed != dshot_get_speed()) {
+        dshot_bb_timing_config();
+    }
+
+    for (int i = 0; i < bb->motor_count; i++) {
+        uint16_t value = values[i];
+
+        /* Clamp throttle value */
+        if (value > DSHOT_THROTTLE_MAX) {
+            value = DSHOT_THROTTLE_MAX;
+        }
+        packets[i] = dshot_create_packet(value, request_telemetry);
+        if (request_telemetry) {
+            bb_telemetry[i].frame_count++;
+        }
+    }
+
+    /* Build the BSRR table, MSB first */
+    uint32_t *slot = bb_buffer;
+    for (int bit = DSHOT_FRAME_SIZE - 1; bit >= 0; bit--) {
+        uint32_t ones = 0;
+
+        for (int i = 0; i < bb->motor_count; i++) {
+            if (packets[i] & (1U << bit)) {
+                ones |= (1UL << bb->pins[i]);
+            }
+        }
+
+        *slot++ = bb_pin_mask << 16;            /* Reset: all pins low */
+        *slot++ = bb_pin_mask & ~ones;          /* Set: '0' bits end here */
+        *slot++ = ones;                         /* Set: '1' bits end here */
+    }
+    *slot = bb_pin_mask;                        /* Trailing idle high */
+
+    bb_request_telemetry = request_telemetry;
+    bb_state = DSHOT_STATE_SENDING;
+    dshot_bb_start_tx();
+
+    return DSHOT_SEND_QUEUED;
+}
+
+/**
+ * @brief Check if the port is ready for the next frame
+ */
+bool dshot_bb_ready(void) {
+    return bb_state == DSHOT_STATE_IDLE;
+}
+
+/**
+ * @brief Decode captured telemetry
+ */
+void dshot_bb_update(void) {
+    const dshot_bb_port_t *bb = &dshot_bb_port;
+
+    if (bb_state != DSHOT_STATE_PROCESSING) {
+        return;
+    }
+
+    for (int i = 0; i < bb->motor_count; i++) {
+        uint32_t raw_bits;
+        dshot_telem_result_t result;
+
+        result = dshot_samples_to_bits(bb_samples, bb_sample_count, 1U << bb->pins[i],
+                                       bb_samples_per_bit_q8, &raw_bits);
+        if (result == DSHOT_TELEM_OK) {
+            result = dshot_decode_gcr_frame(raw_bits, &bb_telemetry[i]);
+        }
+
+        dshot_telem_account(&bb_telemetry[i], result);
+        bool fresh = dshot_erpm_sample(&bb_telemetry[i], result,
+                                       DSHOT_ERPM_FILTER ? &bb_erpm_filter[i] : NULL, dshot_get_erpm_filter(),
+                                       DSHOT_ERPM_MOTION ? &bb_erpm_motion[i] : NULL,
+                                       bb_times.capture_end, DSHOT_TIME_CLOCK_HZ);
+        bb_times.decoded = dshot_time_now();
+        bb_telemetry[i].times = bb_times;
+        if (fresh) {
+            bb_telemetry[i].last_update = bb_times.decoded;
+            bb_new_telemetry[i] = true;
+        }
+    }
+
+    bb_state = DSHOT_STATE_IDLE;
+}
+
+/**
+ * @brief Get telemetry data of one bit-bang motor
+ */
+dshot_telemetry_t* dshot_bb_get_telemetry(uint8_t motor) {
+    if (motor >= dshot_bb_port.motor_count) {
+        return NULL;
+    }
+    return &bb_telemetry[motor];
+}
+
+/**
+ * @brief Check if new telemetry is available for one bit-bang motor
+ */
+bool dshot_bb_telemetry_available(uint8_t motor) {
+    if (motor >= dshot_bb_port.motor_count) {
+        return false;
+    }
+
+    /* Test and clear together, so a sample published in between is not lost */
+    __disable_irq();
+    bool available = bb_new_telemetry[motor];
+    bb_new_telemetry[motor] = false;
+    __enable_irq();
+    return available;
+}
+
+/**
+ * @brief Bit-bang stream interrupt (TX and RX transfer complete)
+ */
+bool dshot_bb_dma_irq_handler(DMA_Stream_TypeDef *stream) {
+    if (stream != dshot_bb_port.stream || bb_pin_mask == 0) {
+        return false;  /* Not the bit-bang stream, or the port is not in use */
+    }
+
+    /* Clear interrupt flag */
+    dshot_dma_clear_flags(dshot_bb_port.dma, dshot_bb_port.stream_index);
+
+    if (bb_state == DSHOT_STATE_SENDING) {
+        if (bb_request_telemetry) {
+            /* Frame out, line idle high - sample the responses */
+            bb_state = DSHOT_STATE_RECEIVING;
+            dshot_bb_start_rx();
+        } else {
+            bb_state = DSHOT_STATE_IDLE;
+        }
+    } else if (bb_state == DSHOT_STATE_RECEIVING) {
+        /* Window complete - drive the pins again and leave decoding to dshot_bb_update() */
+        bb_times.capture_end = dshot_time_now();
+        dshot_bb_pins_output();
+        bb_state = DSHOT_STATE_PROCESSING;
+    }
+
+    return true;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file dshot_capture.c
+ * @brief Raw telemetry capture log
+ *
+ * The receive path (interrupt) is the only writer of the ring; the dump
+ * (main loop) sets capture_paused first. The writer runs at a higher
+ * priority than the dump and completes before the main loop resumes, so
+ * once the flag is set no record can change under the dump. Writers never
+ * preempt each other because they all run at one priority (see
+ * dshot_capture_record() in dshot_capture.h).
+ */
+
+#include "dshot_capture.h"
+
+static dshot_capture_record_t capture_ring[DSHOT_CAPTURE_LOG_SIZE];
+static volatile uint8_t capture_head = 0;      /* Next slot to write */
+static volatile uint8_t capture_count = 0;     /* Valid records */
+static volatile bool capture_paused = false;
+
+static dshot_capture_mode_t capture_mode = DSHOT_CAPTURE_FAILED;
+static uint16_t capture_sample_every = 1;
+static uint16_t capture_sample_phase = 0;
+static uint32_t capture_seq = 0;
+
+/**
+ * @brief Select which receptions are logged
+ */
+void dshot_capture_set_mode(dshot_capture_mode_t mode, uint16_t sample_every) {
+    capture_sample_every = sample_every ? sample_every : 1;
+    capture_sample_phase = 0;
+    capture_mode = mode;
+}
+
+/**
+ * @brief Offer one finished capture to the log
+ */
+void dshot_capture_record(uint8_t motor, const uint16_t *edges, uint8_t edge_count,
+                          uint16_t bit_period, uint32_t rx_scale, dshot_telem_result_t result) {
+    uint32_t seq = capture_seq++;
+
+    if (capture_paused) {
+        return;
+    }
+
+    switch (capture_mode) {
+        case DSHOT_CAPTURE_FAILED:
+            if (DSHOT_TELEM_VALID(result)) {
+                return;
+            }
+            break;
+
+        case DSHOT_CAPTURE_SAMPLED:
+            if (++capture_sample_phase < capture_sample_every) {
+                return;
+            }
+            capture_sample_phase = 0;
+            break;
+
+        default:
+            return;
+    }
+
+    if (edge_count > DSHOT_CAPTURE_MAX_EDGES) {
+        edge_count = DSHOT_CAPTURE_MAX_EDGES;
+    }
+
+    dshot_capture_record_t *r = &capture_ring[capture_head];
+    r->seq = seq;
+    r->rx_scale = rx_scale;
+    r->bit_period = bit_period;
+    r->motor = motor;
+    r->result = result;
+    r->edge_count = edge_count;
+    for (int i = 0; i < edge_count; i++) {
+        r->edges[i] = edges[i];
+    }
+
+    capture_head = (capture_head + 1) & (DSHOT_CAPTURE_LOG_SIZE - 1);
+    if (capture_count < DSHOT_CAPTURE_LOG_SIZE) {
+        capture_count++;
+    }
+}
+
+/**
+ * @brief Number of records currently held
+ */
+uint8_t dshot_capture_count(void) {
+    return capture_count;
+}
+
+/**
+ * @brief Write one byte and fold it into the record check value
+ */
+static void dshot_capture_put(void (*put)(char c), uint8_t byte, uint8_t *check) {
+    put((char)byte);
+    *check ^= byte;
+}
+
+/**
+ * @brief Write a little-endian value of 'bytes' bytes
+ */
+static void dshot_capture_put_le(void (*put)(char c), uint32_t value, uint8_t bytes, uint8_t *check) {
+    for (uint8_t i = 0; i < bytes; i++) {
+        dshot_capture_put(put, (uint8_t)(value >> (i * 8)), check);
+    }
+}
+
+/**
+ * @brief Write the log in the binary dump format and clear it
+ */
+uint8_t dshot_capture_dump(void (*put)(char c)) {
+    capture_paused = true;
+
+    uint8_t count = capture_count;
+    uint8_t index = (capture_head - count) & (DSHOT_CAPTURE_LOG_SIZE - 1);
+    uint8_t unused = 0;
+
+    for (int i = 0; i < DSHOT_CAPTURE_MAGIC_LEN; i++) {
+        put(DSHOT_CAPTURE_MAGIC[i]);
+    }
+    dshot_capture_put(put, count, &unused);
+
+    for (uint8_t n = 0; n < count; n++) {
+        const dshot_capture_record_t *r = &capture_ring[index];
+        uint8_t check = 0;
+
+        dshot_capture_put(put, r->motor, &check);
+        dshot_capture_put(put, r->result, &check);
+        dshot_capture_put(put, r->edge_count, &check);
+        dshot_capture_put_le(put, r->bit_period, 2, &check);
+        dshot_capture_put_le(put, r->rx_scale, 4, &check);
+        dshot_capture_put_le(put, r->seq, 4, &check);
+        for (int i = 0; i < r->edge_count; i++) {
+            dshot_capture_put_le(put, r->edges[i], 2, &check);
+        }
+        put((char)check);
+
+        index = (index + 1) & (DSHOT_CAPTURE_LOG_SIZE - 1);
+    }
+
+    capture_count = 0;
+    capture_paused = false;
+
+    return count;
+}
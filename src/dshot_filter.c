@@ -0,0 +1,174 @@
+/**
+ * @file dshot_filter.c
+ * @brief Streaming eRPM filter: median-of-3 spike rejection and PT1/PT2 low-pass
+ */
+
+#include "dshot_filter.h"
+
+/* 2 * pi in Q16 */
+#define FILTER_TWO_PI_Q16       411775ULL
+
+/* PT2 per-stage cutoff correction 1 / sqrt(2^(1/2) - 1) = 1.5538, Q16 */
+#define FILTER_PT2_SCALE_Q16    101828ULL
+
+/**
+ * @brief Compute low-pass coefficients
+ *
+ * k = w / (1 + w) with w = 2 * pi * fc / fs, the discretised RC stage
+ * y += k * (x - y).
+ */
+bool dshot_erpm_filter_config(dshot_erpm_filter_config_t *config, uint8_t order,
+                              uint16_t cutoff_hz, uint16_t rate_hz) {
+    if (order > DSHOT_ERPM_FILTER_MAX_ORDER || rate_hz == 0 ||
+        (order > 0 && (cutoff_hz == 0 || (uint32_t)cutoff_hz * 2 >= rate_hz))) {
+        return false;
+    }
+
+    uint64_t cutoff_q16 = (uint64_t)cutoff_hz << 16;
+    if (order == 2) {
+        cutoff_q16 = (cutoff_q16 * FILTER_PT2_SCALE_Q16) >> 16;
+    }
+
+    uint64_t w = (FILTER_TWO_PI_Q16 * cutoff_q16 / rate_hz) >> 16;   /* Q16 */
+
+    config->k = (uint32_t)((w << 16) / ((1ULL << 16) + w));
+    config->order = order;
+    return true;
+}
+
+/**
+ * @brief Clear the filter state
+ */
+void dshot_erpm_filter_reset(dshot_erpm_filter_t *filter) {
+    *filter = (dshot_erpm_filter_t){ 0 };
+}
+
+/**
+ * @brief Median of three values
+ */
+static uint32_t dshot_median3(uint32_t a, uint32_t b, uint32_t c) {
+    if (a > b) {
+        uint32_t t = a;
+        a = b;
+        b = t;
+    }
+    /* a <= b: the median is the larger of a and min(b, c) */
+    if (c < a) {
+        return a;
+    }
+    return (c < b) ? c : b;
+}
+
+/**
+ * @brief Feed one raw eRPM value
+ */
+uint32_t dshot_erpm_filter_apply(dshot_erpm_filter_t *filter,
+                                 const dshot_erpm_filter_config_t *config, uint32_t erpm) {
+    uint32_t median;
+
+    filter->history[2] = filter->history[1];
+    filter->history[1] = filter->history[0];
+    filter->history[0] = erpm;
+
+    if (filter->samples < 3) {
+        filter->samples++;
+        median = erpm;
+    } else {
+        median = dshot_median3(filter->history[0], filter->history[1], filter->history[2]);
+    }
+
+    int32_t x = (int32_t)(median << DSHOT_ERPM_FILTER_FRAC);
+
+    for (uint8_t i = 0; i < config->order; i++) {
+        if (filter->samples == 1 || i >= filter->order) {
+            filter->stage[i] = x;   /* First sample or new stage: start settled */
+        } else {
+            filter->stage[i] += (int32_t)(((int64_t)(x - filter->stage[i]) * config->k) >> 16);
+        }
+        x = filter->stage[i];
+    }
+    filter->order = config->order;
+
+    return ((uint32_t)x + (1U << (DSHOT_ERPM_FILTER_FRAC - 1))) >> DSHOT_ERPM_FILTER_FRAC;
+}
+
+/**
+ * @brief Clear the motion estimate
+ */
+void dshot_erpm_motion_reset(dshot_erpm_motion_t *motion) {
+    *motion = (dshot_erpm_motion_t){ 0 };
+}
+
+/**
+ * @brief Clamp to the int32_t range
+ */
+static int32_t dshot_sat32(int64_t value) {
+    if (value > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (value < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)value;
+}
+
+/**
+ * @brief Rate of change: delta * clock_hz / dt, saturated
+ *
+ * clock_hz * 16 / dt is one 32-bit divide; with the 4 fraction bits its
+ * truncation is under 0.01% at 1kHz and under 1% at the longest gap.
+ */
+static int32_t dshot_erpm_rate(int32_t delta, uint32_t dt, uint32_t clock_hz) {
+    uint32_t per_tick = (clock_hz << 4) / dt;
+
+    return dshot_sat32(((int64_t)delta * per_tick) >> 4);
+}
+
+/**
+ * @brief Feed one filtered eRPM sample
+ */
+void dshot_erpm_motion_update(dshot_erpm_motion_t *motion, uint32_t erpm,
+                              uint32_t time, uint32_t clock_hz) {
+    uint32_t dt = time - motion->last_time;
+
+    if (motion->samples > 0 && (dt == 0 || dt > clock_hz / 1000 * DSHOT_ERPM_MOTION_MAX_GAP_MS)) {
+        motion->samples = 0;
+    }
+
+    if (motion->samples == 0) {
+        motion->accel = 0;
+        motion->jerk = 0;
+    } else {
+        int32_t accel = dshot_erpm_rate((int32_t)(erpm - motion->last_erpm), dt, clock_hz);
+
+        motion->jerk = (motion->samples > 1) ?
+                       dshot_erpm_rate(dshot_sat32((int64_t)accel - motion->accel), dt, clock_hz) : 0;
+        motion->accel = accel;
+    }
+
+    if (motion->samples < 3) {
+        motion->samples++;
+    }
+    motion->last_erpm = erpm;
+    motion->last_time = time;
+}
+
+/**
+ * @brief Run one reception through the filter and motion stages
+ */
+bool dshot_erpm_sample(dshot_telemetry_t *telemetry, dshot_telem_result_t result,
+                       dshot_erpm_filter_t *filter, const dshot_erpm_filter_config_t *config,
+                       dshot_erpm_motion_t *motion, uint32_t time, uint32_t clock_hz) {
+    if (result != DSHOT_TELEM_OK) {
+        return false;
+    }
+
+    telemetry->erpm_filtered = filter ? dshot_erpm_filter_apply(filter, config, telemetry->erpm) :
+                                        telemetry->erpm;
+    if (motion) {
+        dshot_erpm_motion_update(motion, telemetry->erpm_filtered, time, clock_hz);
+        telemetry->rpm_accel = dshot_rpm_rate_from_erpm(motion->accel);
+        telemetry->rpm_jerk = dshot_rpm_rate_from_erpm(motion->jerk);
+    }
+    return true;
+}
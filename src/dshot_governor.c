@@ -0,0 +1,82 @@
+/**
+ * @file dshot_governor.c
+ * @brief Fixed-point PI(D) RPM governor
+ */
+
+#include "dshot_governor.h"
+
+/**
+ * @brief Fill a configuration with the DSHOT_GOVERNOR_* defaults
+ */
+void dshot_governor_config_default(dshot_governor_config_t *config) {
+    config->kp = DSHOT_GOVERNOR_KP;
+    config->ki = DSHOT_GOVERNOR_KI;
+    config->kd = DSHOT_GOVERNOR_KD;
+    config->out_min = DSHOT_GOVERNOR_OUT_MIN;
+    config->out_max = DSHOT_GOVERNOR_OUT_MAX;
+    config->slew = DSHOT_GOVERNOR_SLEW;
+}
+
+/**
+ * @brief Restart the governor from a throttle
+ */
+void dshot_governor_reset(dshot_governor_t *gov, const dshot_governor_config_t *config, uint16_t throttle) {
+    if (throttle < config->out_min) {
+        throttle = config->out_min;
+    }
+    if (throttle > config->out_max) {
+        throttle = config->out_max;
+    }
+    gov->integrator = (int64_t)throttle << DSHOT_GOVERNOR_GAIN_FRAC;
+    gov->output = throttle;
+    gov->primed = false;
+}
+
+/**
+ * @brief Run one controller update
+ */
+uint16_t dshot_governor_update(dshot_governor_t *gov, const dshot_governor_config_t *config, uint32_t erpm) {
+    const int64_t lo = (int64_t)config->out_min << DSHOT_GOVERNOR_GAIN_FRAC;
+    const int64_t hi = (int64_t)config->out_max << DSHOT_GOVERNOR_GAIN_FRAC;
+    int32_t error = (int32_t)(gov->setpoint - erpm);
+    int32_t change = gov->primed ? (int32_t)(erpm - gov->prev_erpm) : 0;
+
+    gov->prev_erpm = erpm;
+    gov->primed = true;
+
+    int64_t pd = (int64_t)config->kp * error - (int64_t)config->kd * change;
+    int64_t u = gov->integrator + pd;
+
+    /* Conditional integration: hold the integrator while the output is
+     * saturated and the error would push it further out */
+    if (!((u >= hi && error > 0) || (u <= lo && error < 0))) {
+        gov->integrator += (int64_t)config->ki * error;
+        if (gov->integrator > hi) {
+            gov->integrator = hi;
+        } else if (gov->integrator < lo) {
+            gov->integrator = lo;
+        }
+        u = gov->integrator + pd;
+    }
+
+    /* Round to throttle units and clamp */
+    int32_t target;
+    if (u >= hi) {
+        target = config->out_max;
+    } else if (u <= lo) {
+        target = config->out_min;
+    } else {
+        target = (int32_t)((u + (1L << (DSHOT_GOVERNOR_GAIN_FRAC - 1))) >> DSHOT_GOVERNOR_GAIN_FRAC);
+    }
+
+    /* Slew limit */
+    int32_t step = target - gov->output;
+    if (step > config->slew) {
+        target = gov->output + config->slew;
+    } else if (step < -(int32_t)config->slew) {
+        target = gov->output - config->slew;
+    }
+
+    gov->output = (uint16_t)target;
+    return gov->output;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file dshot_health.c
+ * @brief Motor stall / desync detector
+ */
+
+#include "dshot_health.h"
+#include "dshot_proto.h"
+
+#define HEALTH_AVERAGE_SHIFT    3       /* Collapse reference, 8-sample average */
+#define HEALTH_LEARN_SHIFT      6       /* Band learning, 64-sample time constant */
+
+/**
+ * @brief Fill a configuration with the DSHOT_HEALTH_* defaults
+ */
+void dshot_health_config_default(dshot_health_config_t *config) {
+    config->stall_throttle = DSHOT_HEALTH_STALL_THROTTLE;
+    config->stall_erpm = DSHOT_HEALTH_STALL_ERPM;
+    config->band_pct = DSHOT_HEALTH_BAND_PCT;
+    config->collapse_pct = DSHOT_HEALTH_COLLAPSE_PCT;
+    config->confirm = DSHOT_HEALTH_CONFIRM;
+    config->lag_shift = DSHOT_HEALTH_LAG_SHIFT;
+    config->grace = DSHOT_HEALTH_GRACE;
+    config->auto_cut = DSHOT_HEALTH_AUTO_CUT;
+}
+
+/**
+ * @brief Clear the state including the learned bands
+ */
+void dshot_health_reset(dshot_health_t *health, const dshot_health_config_t *config) {
+    *health = (dshot_health_t){ 0 };
+    health->grace = config->grace;
+}
+
+/**
+ * @brief Clear latched faults, keeping the learned bands
+ */
+void dshot_health_clear(dshot_health_t *health) {
+    health->stall_count = 0;
+    health->desync_count = 0;
+    health->collapse_count = 0;
+    health->faults = 0;
+}
+
+/**
+ * @brief Count a condition and latch its flag once confirmed
+ */
+static void dshot_health_check(dshot_health_t *health, const dshot_health_config_t *config,
+                               bool condition, uint8_t *count, uint8_t flag) {
+    if (!condition) {
+        *count = 0;
+        return;
+    }
+    if (*count < 255) {
+        (*count)++;
+    }
+    if (*count >= config->confirm) {
+        health->faults |= flag;
+    }
+}
+
+/**
+ * @brief Advance the detector by one frame
+ */
+uint8_t dshot_health_update(dshot_health_t *health, const dshot_health_config_t *config,
+                            uint16_t throttle, uint32_t erpm, bool fresh) {
+    if (throttle < DSHOT_THROTTLE_MIN) {
+        /* Stopped or command frame: the next start is a spin-up */
+        health->throttle_lag = 0;
+        health->average_erpm = 0;
+        health->grace = config->grace;
+        health->stall_count = 0;
+        health->desync_count = 0;
+        health->collapse_count = 0;
+        return health->faults;
+    }
+
+    int32_t commanded = throttle - DSHOT_THROTTLE_MIN;
+    health->throttle_lag += ((commanded << 8) - health->throttle_lag) >> config->lag_shift;
+    int32_t lagged = health->throttle_lag >> 8;
+
+    if (!fresh) {
+        return health->faults;
+    }
+
+    if (throttle < config->stall_throttle) {
+        health->grace = config->grace;
+    } else if (health->grace > 0) {
+        health->grace--;
+    }
+
+    bool settled = health->grace == 0;
+    bool slowing = commanded < lagged - lagged / 8;     /* Throttle being reduced */
+    uint8_t bin = (uint8_t)(((uint32_t)lagged * DSHOT_HEALTH_BINS) >> 11);
+    uint32_t ratio = health->ratio[bin];
+
+    /* Stall: should be turning, is not */
+    dshot_health_check(health, config,
+                       settled && lagged + DSHOT_THROTTLE_MIN >= config->stall_throttle &&
+                       erpm < config->stall_erpm,
+                       &health->stall_count, DSHOT_HEALTH_STALL);
+
+    /* Desync: well below the learned band for this throttle */
+    uint32_t expected = (uint32_t)(((uint64_t)ratio * (uint32_t)lagged) >> 8);
+    dshot_health_check(health, config,
+                       settled && !slowing && ratio != 0 &&
+                       (uint64_t)erpm * 100 < (uint64_t)expected * (100 - config->band_pct),
+                       &health->desync_count, DSHOT_HEALTH_DESYNC);
+
+    /* Collapse: sudden drop against the recent average */
+    dshot_health_check(health, config,
+                       !slowing && health->average_erpm >= config->stall_erpm &&
+                       (uint64_t)erpm * 100 < (uint64_t)health->average_erpm * (100 - config->collapse_pct),
+                       &health->collapse_count, DSHOT_HEALTH_COLLAPSE);
+
+    /* An outlier frame may raise the average by at most 1/8 (from no less
+     * than stall_erpm), far from what a later collapse check needs */
+    uint32_t limit = (health->average_erpm > config->stall_erpm) ? health->average_erpm : config->stall_erpm;
+    uint32_t sample = (erpm / 2 > limit) ? limit * 2 : erpm;
+    health->average_erpm += ((int32_t)(sample - health->average_erpm)) >> HEALTH_AVERAGE_SHIFT;
+
+    /* Learn the band from the average while steady and healthy; a motor
+     * drifting more than a quarter band away stops the learning, so a slow
+     * loss of speed is not learned as normal */
+    uint32_t average = health->average_erpm;
+    uint32_t tolerance = expected / 400 * config->band_pct;
+    int32_t diff = commanded - lagged;
+    if (settled && health->faults == 0 && lagged > 0 && average >= config->stall_erpm &&
+        average < (1UL << 24) && diff <= lagged / 16 && -diff <= lagged / 16 &&
+        (ratio == 0 || (average + tolerance >= expected && average <= expected + tolerance))) {
+        uint32_t measured = (average << 8) / (uint32_t)lagged;  /* 32-bit divide */
+
+        if (ratio == 0) {
+            health->ratio[bin] = measured;
+        } else {
+            health->ratio[bin] += ((int32_t)(measured - ratio)) >> HEALTH_LEARN_SHIFT;
+        }
+    }
+
+    return health->faults;
+}
@@ -0,0 +1,453 @@
+/**
+ * @file dshot_proto.c
+ * @brief DShot protocol core: frame encoding and telemetry decoding
+ *
+ * Nothing in this file touches hardware; see dshot.c and dshot_bitbang.c
+ * for the peripherals that feed it.
+ */
+
+#include "dshot_proto.h"
+
+/* GCR decoding lookup table
+ * Maps 5-bit GCR symbols to 4-bit nibbles
+ * Invalid codes map to 0xFF
+ */
+static const uint8_t gcr_decode_table[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,  /* 0x00-0x07 */
+    0xFF, 0x09, 0x0A, 0x0B, 0xFF, 0x0D, 0x0E, 0x0F,  /* 0x08-0x0F */
+    0xFF, 0xFF, 0x02, 0x03, 0xFF, 0x05, 0x06, 0x07,  /* 0x10-0x17 */
+    0xFF, 0x00, 0x08, 0x01, 0xFF, 0x04, 0x0C, 0xFF,  /* 0x18-0x1F */
+};
+
+#if DSHOT_ERPM_TABLE
+/* Reciprocal table: round(60,000,000 * 2^6 / m) for mantissa m
+ * Entry 0 is never read (zero period). m = 1 gives 3.84e9, still below
+ * 2^32 with the largest rounding term of the lookup (2^12 at exponent 7)
+ * added. Q6 keeps the result within 0.51 eRPM after the exponent shift.
+ */
+#define ERPM_Q6(m)      ((uint32_t)(((60000000ULL << DSHOT_ERPM_TABLE_SHIFT) + (m) / 2) / ((m) ? (m) : 1)))
+#define ERPM_ROW8(m)    ERPM_Q6(m), ERPM_Q6((m) + 1), ERPM_Q6((m) + 2), ERPM_Q6((m) + 3), \
+                        ERPM_Q6((m) + 4), ERPM_Q6((m) + 5), ERPM_Q6((m) + 6), ERPM_Q6((m) + 7)
+#define ERPM_ROW64(m)   ERPM_ROW8(m), ERPM_ROW8((m) + 8), ERPM_ROW8((m) + 16), ERPM_ROW8((m) + 24), \
+                        ERPM_ROW8((m) + 32), ERPM_ROW8((m) + 40), ERPM_ROW8((m) + 48), ERPM_ROW8((m) + 56)
+
+static const uint32_t erpm_q6_table[512] = {
+    ERPM_ROW64(0),   ERPM_ROW64(64),  ERPM_ROW64(128), ERPM_ROW64(192),
+    ERPM_ROW64(256), ERPM_ROW64(320), ERPM_ROW64(384), ERPM_ROW64(448),
+};
+#endif
+
+/**
+ * @brief Compute timer constants for a timer clock and protocol speed
+ *
+ * All values are rounded to the nearest timer tick, e.g. at 168MHz:
+ *   DShot150: 1120 ticks/bit, telemetry 896 ticks/bit
+ *   DShot600:  280 ticks/bit, telemetry 224 ticks/bit
+ *   DShot1200: 140 ticks/bit, telemetry 112 ticks/bit
+ */
+void dshot_timing_init(dshot_timing_t *timing, uint32_t timer_clock_hz, uint16_t speed_kbit) {
+    uint32_t bitrate = (uint32_t)speed_kbit * 1000UL;
+    uint32_t telem_bitrate = bitrate * 5 / 4;
+    uint16_t period = (timer_clock_hz + bitrate / 2) / bitrate;
+
+    timing->period = period;
+    /* For inverted DShot (bidirectional), we invert the duty cycles */
+    timing->bit_0_high = period - (period * 3 + 4) / 8;  /* 62.5% high for '0' */
+    timing->bit_1_high = period - (period * 3 + 2) / 4;  /* 25% high for '1' */
+    timing->telem_bit = (timer_clock_hz + telem_bitrate / 2) / telem_bitrate;
+}
+
+/**
+ * @brief Create DShot packet with CRC
+ */
+uint16_t dshot_create_packet(uint16_t value, bool request_telemetry) {
+    /* Packet format: [11-bit value][1-bit telemetry][4-bit CRC] */
+    uint16_t packet = (value << 1) | (request_telemetry ? 1 : 0);
+
+    /* Calculate 4-bit CRC (XOR of nibbles) */
+    uint16_t crc = (packet ^ (packet >> 4) ^ (packet >> 8)) & 0x0F;
+
+    return (packet << 4) | crc;
+}
+
+/**
+ * @brief Encode a packet as CCR values
+ */
+void dshot_encode_frame(uint32_t *buffer, const dshot_timing_t *timing,
+                        uint16_t packet, uint8_t stride) {
+    for (int i = 0; i < DSHOT_FRAME_SIZE; i++) {
+        if (packet & 0x8000) {
+            buffer[i * stride] = timing->bit_1_high;
+        } else {
+            buffer[i * stride] = timing->bit_0_high;
+        }
+        packet <<= 1;
+    }
+    /* Trailing zero to end the frame cleanly */
+    buffer[DSHOT_FRAME_SIZE * stride] = timing->period;  /* Full high for idle */
+}
+
+/**
+ * @brief Convert captured edge timestamps to response bits
+ */
+uint8_t dshot_edges_to_bits(const uint16_t *edges, uint8_t edge_count,
+                            uint16_t bit_period, uint32_t *raw_bits) {
+    uint16_t half_bit = bit_period / 2;
+    uint32_t gcr_bits = 0;
+    uint8_t bit_count = 0;
+    uint8_t current_level = 1;  /* Start high (idle) */
+
+    for (int i = 1; i < edge_count && bit_count < DSHOT_TELEM_FRAME_BITS; i++) {
+        /* Calculate time between edges (uint16_t arithmetic handles timer wrap) */
+        uint16_t delta = (uint16_t)(edges[i] - edges[i-1]);
+
+        /* Determine how many bits this edge represents */
+        uint8_t num_bits = (delta + half_bit) / bit_period;
+        if (num_bits == 0) num_bits = 1;
+        if (num_bits > 5) num_bits = 5;  /* Limit to reasonable value */
+
+        /* Add bits to result */
+        for (int b = 0; b < num_bits && bit_count < DSHOT_TELEM_FRAME_BITS; b++) {
+            gcr_bits = (gcr_bits << 1) | current_level;
+            bit_count++;
+        }
+
+        /* Toggle level after edge */
+        current_level ^= 1;
+    }
+
+    *raw_bits = gcr_bits;
+    return bit_count;
+}
+
+/**
+ * @brief Build the run-length table for dshot_edges_to_bits_table()
+ */
+void dshot_edge_table_init(dshot_edge_table_t *table, uint16_t bit_period) {
+    uint8_t shift = 0;
+
+    /* Largest step 2^shift <= bit_period / 16 */
+    while ((uint32_t)(2U << shift) * 16 <= bit_period) {
+        shift++;
+    }
+
+    uint32_t step = 1UL << shift;
+    uint32_t size = ((6UL * bit_period) >> shift) + 1;
+    if (size > DSHOT_EDGE_TABLE_SIZE) {
+        size = DSHOT_EDGE_TABLE_SIZE;
+    }
+
+    for (uint32_t k = 0; k < size; k++) {
+        /* Round the centre of the bucket to whole bits */
+        uint32_t delta = k * step + step / 2;
+        uint32_t bits = (delta + bit_period / 2) / bit_period;
+        if (bits == 0) bits = 1;
+        if (bits > 5) bits = 5;  /* Limit to reasonable value */
+        table->run[k] = bits;
+    }
+
+    table->bit_period = bit_period;
+    table->shift = shift;
+    table->size = size;
+}
+
+/**
+ * @brief Convert captured edge timestamps to response bits (table-driven)
+ */
+uint8_t dshot_edges_to_bits_table(const dshot_edge_table_t *table, const uint16_t *edges,
+                                  uint8_t edge_count, uint32_t scale_q16, uint32_t *raw_bits) {
+    uint32_t bits = 0;
+    uint32_t count = 0;
+    uint32_t level = 1;         /* Line low after the first edge */
+    uint32_t last = table->size - 1;
+    uint32_t shift = 16 + table->shift;
+
+    for (int i = 1; i < edge_count && count < DSHOT_TELEM_FRAME_BITS; i++) {
+        /* 16-bit delta x Q16 scale needs 33 bits (one UMULL on the M4) */
+        uint32_t index = (uint32_t)(((uint64_t)(uint16_t)(edges[i] - edges[i-1]) * scale_q16) >> shift);
+        uint32_t run = table->run[index < last ? index : last];
+
+        /* Shift the whole run in: all ones while low, all zeros while high */
+        bits = (bits << run) | ((0U - level) & ((1U << run) - 1));
+        count += run;
+        level ^= 1;
+    }
+
+    /* The last run may overshoot 21 bits (at most by 4, so 32 bits suffice) */
+    if (count > DSHOT_TELEM_FRAME_BITS) {
+        bits >>= count - DSHOT_TELEM_FRAME_BITS;
+        count = DSHOT_TELEM_FRAME_BITS;
+    }
+
+    *raw_bits = bits;
+    return count;
+}
+
+/**
+ * @brief Refine the receive clock estimate from a successfully decoded frame
+ */
+uint32_t dshot_rx_scale_update(const dshot_edge_table_t *table, const uint16_t *edges,
+                               uint8_t edge_count, uint32_t scale_q16) {
+    uint32_t last = table->size - 1;
+    uint32_t shift = 16 + table->shift;
+    uint32_t span = 0;
+    uint32_t count = 0;
+
+    /* Same runs as the decode, but only whole runs inside the frame */
+    for (int i = 1; i < edge_count; i++) {
+        uint16_t delta = (uint16_t)(edges[i] - edges[i-1]);
+        uint32_t index = (uint32_t)(((uint64_t)delta * scale_q16) >> shift);
+        uint32_t run = table->run[index < last ? index : last];
+
+        if (count + run > DSHOT_TELEM_FRAME_BITS) {
+            break;
+        }
+        span += delta;
+        count += run;
+    }
+
+    if (span == 0) {
+        return scale_q16;
+    }
+
+    /* This frame's ratio: count bits at the nominal period took span ticks */
+    uint32_t measured = (uint32_t)(((uint64_t)count * table->bit_period << 16) / span);
+
+    int32_t error = (int32_t)(measured - scale_q16);
+    scale_q16 += error / (1 << DSHOT_RX_SCALE_FILTER_SHIFT);
+
+    if (scale_q16 < DSHOT_RX_SCALE_MIN) scale_q16 = DSHOT_RX_SCALE_MIN;
+    if (scale_q16 > DSHOT_RX_SCALE_MAX) scale_q16 = DSHOT_RX_SCALE_MAX;
+
+    return scale_q16;
+}
+
+/**
+ * @brief Convert oversampled line levels to response bits
+ */
+dshot_telem_result_t dshot_samples_to_bits(const uint16_t *samples, uint16_t sample_count,
+                                           uint16_t pin_mask, uint32_t samples_per_bit_q8,
+                                           uint32_t *raw_bits) {
+    uint16_t i = 0;
+
+    /* Find start of response */
+    while (i < sample_count && (samples[i] & pin_mask)) {
+        i++;
+    }
+    if (i == sample_count) {
+        return DSHOT_TELEM_ERR_TIMEOUT;  /* No response */
+    }
+
+    uint32_t bits = 0;
+    uint8_t bit_count = 0;
+    uint8_t level = 1;              /* Line low */
+    uint16_t run_start = i;
+
+    for (i++; i < sample_count && bit_count < DSHOT_TELEM_FRAME_BITS; i++) {
+        uint8_t sample_level = (samples[i] & pin_mask) ? 0 : 1;
+        if (sample_level == level) {
+            continue;
+        }
+
+        uint32_t run = i - run_start;
+        uint8_t num_bits = ((run << 8) + samples_per_bit_q8 / 2) / samples_per_bit_q8;
+        if (num_bits == 0) num_bits = 1;
+        if (num_bits > 5) num_bits = 5;  /* Limit to reasonable value */
+        if (num_bits > DSHOT_TELEM_FRAME_BITS - bit_count) {
+            num_bits = DSHOT_TELEM_FRAME_BITS - bit_count;
+        }
+
+        bits = (bits << num_bits) | (level ? ((1UL << num_bits) - 1) : 0);
+        bit_count += num_bits;
+
+        level = sample_level;
+        run_start = i;
+    }
+
+    if (bit_count < DSHOT_TELEM_MIN_BITS) {
+        return DSHOT_TELEM_ERR_BITS;  /* Too few bits */
+    }
+
+    /* Trailing idle-level bits */
+    bits <<= (DSHOT_TELEM_FRAME_BITS - bit_count);
+
+    *raw_bits = bits;
+    return DSHOT_TELEM_OK;
+}
+
+/**
+ * @brief Decode GCR value to nibbles
+ *
+ * GCR encoding uses 5 bits to represent 4 bits, ensuring no long runs
+ * of same bits which helps with signal integrity.
+ */
+uint32_t dshot_decode_gcr(uint32_t gcr_value) {
+    uint32_t result = 0;
+
+    /* Extract 4 nibbles from 20 GCR bits (MSB first) */
+    for (int i = 0; i < DSHOT_TELEM_NIBBLES; i++) {
+        uint8_t gcr_symbol = (gcr_value >> (15 - i * DSHOT_GCR_BITS)) & 0x1F;
+        uint8_t nibble = gcr_decode_table[gcr_symbol];
+
+        if (nibble == 0xFF) {
+            return 0xFFFFFFFF;  /* Invalid GCR symbol */
+        }
+
+        result = (result << 4) | nibble;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Convert the 12-bit eRPM value to a period
+ */
+uint32_t dshot_telem_period_us(uint16_t value) {
+    return (uint32_t)(value & 0x1FF) << ((value >> 9) & 0x7);
+}
+
+/**
+ * @brief Convert a period to eRPM
+ *
+ * eRPM = 60,000,000 / period_us, rounded to nearest.
+ */
+uint32_t dshot_erpm_from_period(uint32_t period_us) {
+    if (period_us == 0) {
+        return 0;
+    }
+    return (60000000UL + period_us / 2) / period_us;
+}
+
+/**
+ * @brief Convert the 12-bit eRPM value straight to eRPM
+ *
+ * Table backend: erpm = round(table[m] / 2^(6 + e)), one load and a shift.
+ */
+uint32_t dshot_erpm_from_value(uint16_t value) {
+    uint32_t mantissa = value & 0x1FF;
+
+    if (mantissa == 0) {
+        return 0;
+    }
+#if DSHOT_ERPM_TABLE
+    uint32_t shift = DSHOT_ERPM_TABLE_SHIFT + ((value >> 9) & 0x7);
+    return (erpm_q6_table[mantissa] + (1UL << (shift - 1))) >> shift;
+#else
+    return dshot_erpm_from_period(dshot_telem_period_us(value));
+#endif
+}
+
+/**
+ * @brief Convert an eRPM rate to the RPM rate
+ */
+int32_t dshot_rpm_rate_from_erpm(int32_t erpm_rate) {
+    return erpm_rate / (MOTOR_POLES / 2);
+}
+
+/**
+ * @brief Decode a sampled 21-bit response into telemetry
+ *
+ * Shared by the input-capture and IDR-sampling receivers.
+ */
+dshot_telem_result_t dshot_decode_gcr_frame(uint32_t raw_bits, dshot_telemetry_t *telemetry) {
+    /* Transition decode: a GCR '1' is a level change between adjacent bits */
+    uint32_t gcr_value = (raw_bits ^ (raw_bits >> 1)) & 0xFFFFF;
+
+    /* Decode GCR to get 16-bit value */
+    uint32_t decoded = dshot_decode_gcr(gcr_value);
+    if (decoded == 0xFFFFFFFF) {
+        return DSHOT_TELEM_ERR_GCR;  /* GCR decode error */
+    }
+
+    /* Verify CRC: XOR of all four nibbles is 0xF (CRC is sent inverted) */
+    uint32_t csum = decoded ^ (decoded >> 4) ^ (decoded >> 8) ^ (decoded >> 12);
+    if ((csum & 0x0F) != 0x0F) {
+        return DSHOT_TELEM_ERR_CRC;  /* CRC mismatch */
+    }
+
+    uint16_t value = decoded >> 4;
+
+    if (DSHOT_EDT_IS_EXTENDED(value)) {
+        dshot_edt_t *edt = &telemetry->edt;
+        uint8_t data = value & 0xFF;
+
+        switch (value & DSHOT_EDT_TYPE_MASK) {
+            case DSHOT_EDT_TEMPERATURE:
+                edt->temperature = data;
+                break;
+            case DSHOT_EDT_VOLTAGE:
+                edt->voltage = data;
+                break;
+            case DSHOT_EDT_CURRENT:
+                edt->current = data;
+                break;
+            case DSHOT_EDT_DEBUG1:
+                edt->debug1 = data;
+                break;
+            case DSHOT_EDT_DEBUG2:
+                edt->debug2 = data;
+                break;
+            case DSHOT_EDT_STRESS:
+                edt->stress = data;
+                break;
+            case DSHOT_EDT_STATUS:
+                edt->status = data;
+                break;
+            default:
+                break;
+        }
+        edt->received |= DSHOT_EDT_BIT(value & DSHOT_EDT_TYPE_MASK);
+        return DSHOT_TELEM_EDT;
+    }
+
+    if (value == DSHOT_TELEM_STOPPED) {
+        telemetry->period_us = dshot_telem_period_us(value);
+        telemetry->erpm = 0;
+        telemetry->rpm = 0;
+        return DSHOT_TELEM_OK;
+    }
+
+    /* Store telemetry data
+     * Actual RPM = eRPM / pole pairs = eRPM * 2 / motor_poles
+     * (MOTOR_POLES is a constant, so the compiler emits a multiply)
+     */
+    telemetry->period_us = dshot_telem_period_us(value);
+    telemetry->erpm = dshot_erpm_from_value(value);
+    telemetry->rpm = (telemetry->erpm * 2 + MOTOR_POLES / 2) / MOTOR_POLES;
+
+    return DSHOT_TELEM_OK;
+}
+
+/**
+ * @brief Clear telemetry data, counters and link quality
+ */
+void dshot_telem_reset(dshot_telemetry_t *telemetry) {
+    *telemetry = (dshot_telemetry_t){ 0 };
+}
+
+/**
+ * @brief Count one reception outcome
+ */
+void dshot_telem_account(dshot_telemetry_t *telemetry, dshot_telem_result_t result) {
+    uint32_t good = DSHOT_TELEM_VALID(result) ? 1 : 0;
+
+    if (result == DSHOT_TELEM_OK) {
+        telemetry->valid = true;
+        telemetry->success_count++;
+    } else if (result == DSHOT_TELEM_EDT) {
+        telemetry->edt_count++;
+    } else {
+        telemetry->error_count++;
+        telemetry->errors[result]++;
+    }
+
+    /* Shift the outcome in; the bit falling out of the window leaves the count */
+    if (telemetry->lq_frames < DSHOT_LINK_QUALITY_WINDOW) {
+        telemetry->lq_frames++;
+    } else {
+        telemetry->lq_good -= (telemetry->lq_history >> (DSHOT_LINK_QUALITY_WINDOW - 1)) & 1;
+    }
+    telemetry->lq_history = (telemetry->lq_history << 1) | good;
+    telemetry->lq_good += good;
+    telemetry->link_quality = (telemetry->lq_good * 100U) / telemetry->lq_frames;
+}
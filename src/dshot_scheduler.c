@@ -0,0 +1,467 @@
+/**
+ * @file dshot_scheduler.c
+ * @brief Hardware-timed DShot frame scheduler
+ *
+ * The scheduler timer runs without prescaler and raises an update
+ * interrupt once per frame period. Each interrupt advances the telemetry
+ * state machine, then encodes and arms the latest throttle for every
+ * motor that is idle. The timer counter value read on entry is the
+ * latency since the update event; the difference between consecutive
+ * latencies is the deviation of the inter-frame interval from nominal.
+ *
+ * Motors in governor mode (dshot_scheduler_set_rpm()) get their throttle
+ * from a per-motor PI(D) controller fed with the telemetry snapshot. The
+ * same snapshot and the throttle actually sent feed the per-motor stall /
+ * desync detector, which may replace the throttle with motor stop; the
+ * governor of a cut motor is held and restarts from the fallback throttle
+ * when the fault is cleared.
+ *
+ * The command queues are single-producer (main loop) / single-consumer
+ * (scheduler interrupt) rings: the producer only writes the head index,
+ * the interrupt only writes the tail index.
+ */
+
+#include "dshot_scheduler.h"
+#include "dshot.h"
+#include "stm32f4xx.h"
+
+/* Latest commanded throttle per motor (open-loop fallback in governor mode) */
+static volatile uint16_t sched_throttle[DSHOT_MOTOR_COUNT];
+
+/* Last telemetry snapshot read per motor */
+static dshot_telemetry_t sched_telem[DSHOT_MOTOR_COUNT];
+
+/* RPM governor per motor */
+static dshot_governor_t gov_state[DSHOT_MOTOR_COUNT];
+static volatile uint32_t gov_target[DSHOT_MOTOR_COUNT];   /* Setpoint, eRPM */
+static volatile bool gov_enabled[DSHOT_MOTOR_COUNT];
+static volatile bool gov_engaged[DSHOT_MOTOR_COUNT];      /* Closed loop running */
+static dshot_governor_config_t gov_config = {
+    .kp = DSHOT_GOVERNOR_KP,
+    .ki = DSHOT_GOVERNOR_KI,
+    .kd = DSHOT_GOVERNOR_KD,
+    .out_min = DSHOT_GOVERNOR_OUT_MIN,
+    .out_max = DSHOT_GOVERNOR_OUT_MAX,
+    .slew = DSHOT_GOVERNOR_SLEW,
+};
+
+/* Stall / desync detector per motor */
+static dshot_health_t health_state[DSHOT_MOTOR_COUNT];
+static volatile bool health_clear[DSHOT_MOTOR_COUNT];     /* Clear requested by the main loop */
+static volatile bool health_reset = true;                  /* Reset all on the next tick */
+static dshot_health_config_t health_config = {
+    .stall_throttle = DSHOT_HEALTH_STALL_THROTTLE,
+    .stall_erpm = DSHOT_HEALTH_STALL_ERPM,
+    .band_pct = DSHOT_HEALTH_BAND_PCT,
+    .collapse_pct = DSHOT_HEALTH_COLLAPSE_PCT,
+    .confirm = DSHOT_HEALTH_CONFIRM,
+    .lag_shift = DSHOT_HEALTH_LAG_SHIFT,
+    .grace = DSHOT_HEALTH_GRACE,
+    .auto_cut = DSHOT_HEALTH_AUTO_CUT,
+};
+
+/* Queued special command */
+typedef struct {
+    uint8_t  command;
+    uint8_t  repeat;            /* Frames to send */
+    uint32_t spacing_us;        /* Gap after the last frame */
+} sched_command_t;
+
+/* Per-motor command FIFO */
+static sched_command_t cmd_queue[DSHOT_MOTOR_COUNT][DSHOT_CMD_QUEUE_SIZE];
+static volatile uint8_t cmd_head[DSHOT_MOTOR_COUNT];
+static volatile uint8_t cmd_tail[DSHOT_MOTOR_COUNT];
+static uint8_t cmd_sent[DSHOT_MOTOR_COUNT];     /* Frames sent of the entry at tail */
+static uint32_t cmd_gap[DSHOT_MOTOR_COUNT];     /* Ticks until the next entry may start */
+
+#if (DSHOT_CMD_QUEUE_SIZE & (DSHOT_CMD_QUEUE_SIZE - 1)) != 0
+#error "DSHOT_CMD_QUEUE_SIZE must be a power of two"
+#endif
+
+static volatile bool sched_running = false;
+static uint32_t sched_rate_hz = 0;
+static uint32_t sched_period_ticks = 0;
+
+/* Statistics in scheduler timer ticks (converted to ns on read) */
+static volatile uint32_t stat_ticks = 0;
+static volatile uint32_t stat_frames = 0;
+static volatile uint32_t stat_busy = 0;
+static volatile uint32_t stat_commands = 0;
+static volatile uint32_t stat_interval_min = 0xFFFFFFFF;
+static volatile uint32_t stat_interval_max = 0;
+static volatile uint32_t stat_jitter_max = 0;
+static volatile uint32_t stat_latency_max = 0;
+static uint32_t prev_latency = 0;
+static bool have_prev = false;
+
+/**
+ * @brief Convert scheduler timer ticks to nanoseconds
+ */
+static uint32_t sched_ticks_to_ns(uint32_t ticks) {
+    return (uint32_t)(((uint64_t)ticks * 1000000000ULL) / DSHOT_SCHED_TIMER_CLOCK_HZ);
+}
+
+/**
+ * @brief Start sending frames at a fixed rate
+ */
+bool dshot_scheduler_start(uint32_t rate_hz) {
+    if (rate_hz != DSHOT_SCHED_RATE_1KHZ && rate_hz != DSHOT_SCHED_RATE_2KHZ &&
+        rate_hz != DSHOT_SCHED_RATE_4KHZ && rate_hz != DSHOT_SCHED_RATE_8KHZ) {
+        return false;
+    }
+
+    dshot_scheduler_stop();
+
+    sched_rate_hz = rate_hz;
+    sched_period_ticks = DSHOT_SCHED_TIMER_CLOCK_HZ / rate_hz;
+    dshot_scheduler_reset_stats();
+
+    /* Enable timer clock */
+    RCC->APB1ENR |= DSHOT_SCHED_TIMER_RCC;
+
+    /* Configure timer for a periodic update interrupt */
+    DSHOT_SCHED_TIMER->CR1 = 0;                        /* Disable timer */
+    DSHOT_SCHED_TIMER->PSC = 0;                        /* No prescaler */
+    DSHOT_SCHED_TIMER->ARR = sched_period_ticks - 1;   /* One frame period */
+    DSHOT_SCHED_TIMER->CNT = 0;
+    DSHOT_SCHED_TIMER->EGR = TIM_EGR_UG;               /* Load PSC/ARR */
+    DSHOT_SCHED_TIMER->SR = 0;
+    DSHOT_SCHED_TIMER->DIER = TIM_DIER_UIE;            /* Update interrupt */
+
+    NVIC_SetPriority(DSHOT_SCHED_TIMER_IRQn, DSHOT_SCHED_IRQ_PRIORITY);
+    NVIC_EnableIRQ(DSHOT_SCHED_TIMER_IRQn);
+
+    sched_running = true;
+    DSHOT_SCHED_TIMER->CR1 |= TIM_CR1_CEN;
+
+    return true;
+}
+
+/**
+ * @brief Stop the scheduler
+ */
+void dshot_scheduler_stop(void) {
+    DSHOT_SCHED_TIMER->CR1 &= ~TIM_CR1_CEN;
+    DSHOT_SCHED_TIMER->DIER &= ~TIM_DIER_UIE;
+    NVIC_DisableIRQ(DSHOT_SCHED_TIMER_IRQn);
+    sched_running = false;
+}
+
+/**
+ * @brief Check if the scheduler is running
+ */
+bool dshot_scheduler_running(void) {
+    return sched_running;
+}
+
+/**
+ * @brief Set the throttle sent to a motor on every following tick
+ */
+void dshot_scheduler_set_throttle(uint8_t motor, uint16_t throttle) {
+    if (motor < DSHOT_MOTOR_COUNT) {
+        gov_enabled[motor] = false;
+        sched_throttle[motor] = throttle;  /* Single halfword store, atomic */
+    }
+}
+
+/**
+ * @brief Hold a motor at an RPM with the closed-loop governor
+ */
+void dshot_scheduler_set_rpm(uint8_t motor, uint32_t rpm, uint16_t fallback_throttle) {
+    if (motor >= DSHOT_MOTOR_COUNT) {
+        return;
+    }
+
+    sched_throttle[motor] = fallback_throttle;
+    gov_target[motor] = rpm * (MOTOR_POLES / 2);
+    if (!gov_enabled[motor]) {
+        gov_engaged[motor] = false;  /* Restart from the fallback throttle */
+        __DMB();
+        gov_enabled[motor] = true;
+    }
+}
+
+/**
+ * @brief Replace the governor tuning of all motors
+ */
+void dshot_scheduler_set_governor(const dshot_governor_config_t *config) {
+    __disable_irq();
+    gov_config = *config;
+    __enable_irq();
+}
+
+/**
+ * @brief Check whether a motor is currently under closed-loop control
+ */
+bool dshot_scheduler_governor_engaged(uint8_t motor) {
+    return motor < DSHOT_MOTOR_COUNT && gov_enabled[motor] && gov_engaged[motor];
+}
+
+/**
+ * @brief Throttle of a motor in governor mode for this tick
+ *
+ * Open loop at the fallback throttle while telemetry is stale; the
+ * controller runs only when the snapshot holds a new sample.
+ */
+static uint16_t sched_governor_step(uint8_t motor, bool fresh) {
+    dshot_governor_t *gov = &gov_state[motor];
+    const dshot_telemetry_t *telem = &sched_telem[motor];
+    uint16_t fallback = sched_throttle[motor];
+
+    if (gov_target[motor] == 0) {
+        gov_engaged[motor] = false;
+        return 0;  /* Motor stop */
+    }
+    if (dshot_telem_age_us(telem) > DSHOT_GOVERNOR_TIMEOUT_US) {
+        gov_engaged[motor] = false;
+        return fallback;
+    }
+    if (!gov_engaged[motor]) {
+        dshot_governor_reset(gov, &gov_config, fallback);
+        gov_engaged[motor] = true;
+    }
+
+    gov->setpoint = gov_target[motor];
+    if (fresh) {
+        dshot_governor_update(gov, &gov_config, telem->erpm_filtered);
+    }
+    return gov->output;
+}
+
+/**
+ * @brief Latched stall / desync / collapse flags of a motor
+ */
+uint8_t dshot_scheduler_get_faults(uint8_t motor) {
+    return (motor < DSHOT_MOTOR_COUNT) ? health_state[motor].faults : 0;
+}
+
+/**
+ * @brief Clear the latched faults of a motor
+ */
+void dshot_scheduler_clear_faults(uint8_t motor) {
+    if (motor < DSHOT_MOTOR_COUNT) {
+        health_clear[motor] = true;  /* Applied by the scheduler interrupt */
+    }
+}
+
+/**
+ * @brief Replace the stall / desync detector tuning of all motors
+ */
+void dshot_scheduler_set_health(const dshot_health_config_t *config) {
+    __disable_irq();
+    health_config = *config;
+    health_reset = true;  /* Grace and lag depend on the tuning */
+    __enable_irq();
+}
+
+/**
+ * @brief Queue a special command with explicit repeat count and spacing
+ */
+bool dshot_scheduler_queue_command(uint8_t motor, uint8_t command, uint8_t repeat, uint32_t spacing_us) {
+    if (motor >= DSHOT_MOTOR_COUNT || command > DSHOT_CMD_MAX || repeat == 0) {
+        return false;
+    }
+
+    uint8_t head = cmd_head[motor];
+    if ((uint8_t)(head - cmd_tail[motor]) >= DSHOT_CMD_QUEUE_SIZE) {
+        return false;  /* Queue full */
+    }
+
+    sched_command_t *entry = &cmd_queue[motor][head & (DSHOT_CMD_QUEUE_SIZE - 1)];
+    entry->command = command;
+    entry->repeat = repeat;
+    entry->spacing_us = spacing_us;
+
+    __DMB();  /* Entry visible before the interrupt sees the new head */
+    cmd_head[motor] = head + 1;
+
+    return true;
+}
+
+/**
+ * @brief Queue a special command with the repeat count and spacing it requires
+ */
+bool dshot_scheduler_send_command(uint8_t motor, uint8_t command) {
+    uint8_t repeat = 1;
+    uint32_t spacing_us = DSHOT_CMD_SPACING_US;
+
+    switch (command) {
+        case DSHOT_CMD_BEEP1:
+        case DSHOT_CMD_BEEP2:
+        case DSHOT_CMD_BEEP3:
+        case DSHOT_CMD_BEEP4:
+        case DSHOT_CMD_BEEP5:
+            spacing_us = DSHOT_CMD_BEEP_SPACING_US;
+            break;
+
+        case DSHOT_CMD_ESC_INFO:
+            spacing_us = DSHOT_CMD_ESC_INFO_SPACING_US;
+            break;
+
+        case DSHOT_CMD_SPIN_DIR_1:
+        case DSHOT_CMD_SPIN_DIR_2:
+        case DSHOT_CMD_3D_MODE_OFF:
+        case DSHOT_CMD_3D_MODE_ON:
+        case DSHOT_CMD_SAVE_SETTINGS:
+        case DSHOT_CMD_EXTENDED_TELEM_ENABLE:
+        case DSHOT_CMD_EXTENDED_TELEM_DISABLE:
+            repeat = DSHOT_CMD_REPEAT_SETTINGS;
+            break;
+
+        default:
+            break;
+    }
+
+    return dshot_scheduler_queue_command(motor, command, repeat, spacing_us);
+}
+
+/**
+ * @brief Check if a motor still has queued or in-progress commands
+ */
+bool dshot_scheduler_command_pending(uint8_t motor) {
+    return motor < DSHOT_MOTOR_COUNT && cmd_head[motor] != cmd_tail[motor];
+}
+
+/**
+ * @brief Send the next command frame of a motor if one is due
+ * @return true if a command frame was armed (throttle is skipped this tick)
+ */
+static bool sched_send_command(uint8_t motor) {
+    uint8_t tail = cmd_tail[motor];
+
+    if (cmd_gap[motor] > 0 || tail == cmd_head[motor]) {
+        return false;
+    }
+
+    const sched_command_t *entry = &cmd_queue[motor][tail & (DSHOT_CMD_QUEUE_SIZE - 1)];
+
+    dshot_motor_prepare_command(motor, entry->command);
+    if (dshot_motor_send_prepared(motor) != DSHOT_SEND_QUEUED) {
+        return true;  /* Retry this repeat on the next tick */
+    }
+    stat_commands++;
+
+    if (++cmd_sent[motor] >= entry->repeat) {
+        /* Entry done: hold off the next one for its spacing (rounded up) */
+        cmd_gap[motor] = (uint32_t)(((uint64_t)entry->spacing_us * sched_rate_hz + 999999UL) / 1000000UL);
+        cmd_sent[motor] = 0;
+        cmd_tail[motor] = tail + 1;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get scheduler timing statistics
+ */
+void dshot_scheduler_get_stats(dshot_scheduler_stats_t *stats) {
+    stats->rate_hz = sched_rate_hz;
+    stats->ticks = stat_ticks;
+    stats->frames_sent = stat_frames;
+    stats->busy_skips = stat_busy;
+    stats->commands_sent = stat_commands;
+    stats->interval_min_ns = (stat_interval_min == 0xFFFFFFFF) ? 0 : sched_ticks_to_ns(stat_interval_min);
+    stats->interval_max_ns = sched_ticks_to_ns(stat_interval_max);
+    stats->jitter_max_ns = sched_ticks_to_ns(stat_jitter_max);
+    stats->latency_max_ns = sched_ticks_to_ns(stat_latency_max);
+}
+
+/**
+ * @brief Reset scheduler timing statistics
+ */
+void dshot_scheduler_reset_stats(void) {
+    stat_ticks = 0;
+    stat_frames = 0;
+    stat_busy = 0;
+    stat_commands = 0;
+    stat_interval_min = 0xFFFFFFFF;
+    stat_interval_max = 0;
+    stat_jitter_max = 0;
+    stat_latency_max = 0;
+    have_prev = false;
+}
+
+/**
+ * @brief Scheduler timer update interrupt handler
+ */
+void TIM5_IRQHandler(void) {
+    /* Ticks elapsed since the update event that raised this interrupt */
+    uint32_t latency = DSHOT_SCHED_TIMER->CNT;
+
+    /* Clear interrupt flag */
+    DSHOT_SCHED_TIMER->SR = ~TIM_SR_UIF;
+
+    /* Advance telemetry reception, then send on every idle motor */
+    dshot_update();
+
+#if DSHOT_HEALTH
+    if (health_reset) {
+        for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+            dshot_health_reset(&health_state[i], &health_config);
+        }
+        health_reset = false;
+    }
+#endif
+
+    for (int i = 0; i < DSHOT_MOTOR_COUNT; i++) {
+        if (cmd_gap[i] > 0) {
+            cmd_gap[i]--;
+        }
+        if (!dshot_motor_ready(i)) {
+            stat_busy++;
+            continue;
+        }
+        if (sched_send_command(i)) {
+#if DSHOT_HEALTH
+            dshot_health_update(&health_state[i], &health_config, 0, 0, false);
+#endif
+            continue;  /* Command frame replaces this tick's throttle */
+        }
+
+        bool fresh = dshot_motor_read_telemetry(i, &sched_telem[i]);
+        bool cut = false;
+
+#if DSHOT_HEALTH
+        if (health_clear[i]) {
+            dshot_health_clear(&health_state[i]);
+            health_clear[i] = false;
+        }
+        cut = health_state[i].faults && health_config.auto_cut;
+#endif
+
+        uint16_t throttle;
+        if (cut) {
+            /* The stopped motor still reports 0 eRPM: keep the governor out
+             * of the loop so it restarts from the fallback once cleared */
+            gov_engaged[i] = false;
+            throttle = DSHOT_CMD_MOTOR_STOP;
+        } else {
+            throttle = gov_enabled[i] ? sched_governor_step(i, fresh) : sched_throttle[i];
+        }
+
+#if DSHOT_HEALTH
+        dshot_health_update(&health_state[i], &health_config, throttle,
+                            sched_telem[i].erpm, fresh);
+#endif
+        dshot_motor_prepare_throttle(i, throttle);
+        if (dshot_motor_send_prepared(i) == DSHOT_SEND_QUEUED) {
+            stat_frames++;
+        }
+    }
+
+    /* Timing statistics */
+    stat_ticks++;
+    if (latency > stat_latency_max) {
+        stat_latency_max = latency;
+    }
+    if (have_prev) {
+        uint32_t interval = sched_period_ticks + latency - prev_latency;
+        uint32_t deviation = (latency > prev_latency) ? latency - prev_latency
+                                                      : prev_latency - latency;
+        if (interval < stat_interval_min) stat_interval_min = interval;
+        if (interval > stat_interval_max) stat_interval_max = interval;
+        if (deviation > stat_jitter_max) stat_jitter_max = deviation;
+    }
+    prev_latency = latency;
+    have_prev = true;
+}
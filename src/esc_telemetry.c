@@ -4,10 +4,12 @@
  *
  * This module wraps the bidirectional DShot telemetry to provide
  * a compatible API with the original serial telemetry interface.
+ * Voltage, current and temperature come from EDT frames.
  */
 
 #include "esc_telemetry.h"
 #include "dshot.h"
+#include "dshot_scheduler.h"
 
 /* Local telemetry data structure for API compatibility */
 static esc_telemetry_t local_telemetry = {0};
@@ -25,21 +27,37 @@ bool esc_telemetry_init(void) {
     local_telemetry.voltage = 0;
     local_telemetry.current = 0;
     local_telemetry.consumption = 0;
+    local_telemetry.stress = 0;
+    local_telemetry.status = 0;
+    local_telemetry.edt_valid = false;
     return true;
 }
 
+/**
+ * @brief Ask the ESC to enable Extended DShot Telemetry
+ */
+bool esc_telemetry_enable_edt(void) {
+    return dshot_scheduler_send_command(0, DSHOT_CMD_EXTENDED_TELEM_ENABLE);
+}
+
 /**
  * @brief Process incoming telemetry data
  *
  * This calls dshot_update() to process the bidirectional telemetry
- * state machine and copies data to the local structure.
+ * state machine (unless the frame scheduler is driving it) and copies
+ * data to the local structure.
  */
 void esc_telemetry_update(void) {
-    /* Process bidirectional DShot telemetry */
-    dshot_update();
+    /* Process bidirectional DShot telemetry (the scheduler does this while running) */
+    if (!dshot_scheduler_running()) {
+        dshot_update();
+    }
 
-    /* Copy data from DShot telemetry to local structure */
-    dshot_telemetry_t* dshot_telem = dshot_get_telemetry();
+    /* Copy data from a consistent DShot telemetry snapshot */
+    static dshot_telemetry_t snapshot;
+    const dshot_telemetry_t *dshot_telem = &snapshot;
+
+    dshot_motor_read_telemetry(0, &snapshot);
 
     if (dshot_telem->valid) {
         local_telemetry.erpm = dshot_telem->erpm / 100;  /* Convert to erpm/100 format */
@@ -47,11 +65,18 @@ void esc_telemetry_update(void) {
         local_telemetry.valid = true;
         local_telemetry.last_update = dshot_telem->last_update;
 
-        /* These are not available with basic bidirectional DShot */
-        local_telemetry.temperature = 0;
-        local_telemetry.voltage = 0;
-        local_telemetry.current = 0;
-        local_telemetry.consumption = 0;
+    }
+
+    /* EDT fields, each at the rate the ESC sends it */
+    const dshot_edt_t *edt = &dshot_telem->edt;
+
+    if (edt->received) {
+        local_telemetry.temperature = edt->temperature;
+        local_telemetry.voltage = (uint16_t)edt->voltage * 25;     /* 0.25V -> 0.01V */
+        local_telemetry.current = (uint16_t)edt->current * 100;    /* 1A -> 0.01A */
+        local_telemetry.stress = edt->stress;
+        local_telemetry.status = edt->status;
+        local_telemetry.edt_valid = true;
     }
 }
 
@@ -81,18 +106,14 @@ bool esc_telemetry_available(void) {
 
 /**
  * @brief Get voltage as float in volts
- * @return 0.0 (not available with basic bidirectional DShot)
  */
 float esc_telemetry_get_voltage_v(void) {
-    /* Not available with basic bidirectional DShot */
-    return 0.0f;
+    return local_telemetry.voltage / 100.0f;
 }
 
 /**
  * @brief Get current as float in amps
- * @return 0.0 (not available with basic bidirectional DShot)
  */
 float esc_telemetry_get_current_a(void) {
-    /* Not available with basic bidirectional DShot */
-    return 0.0f;
+    return local_telemetry.current / 100.0f;
 }
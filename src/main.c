@@ -6,14 +6,21 @@
  * - Bidirectional DShot600 motor control
  * - Single-wire telemetry (RPM data on same signal wire)
  * - Real-time RPM display
+ * - Hardware-timed frame output (dshot_scheduler), independent of UART printing
+ * - Closed-loop RPM governor test (dshot_scheduler_set_rpm())
  */
 
 #include "dshot.h"
+#include "dshot_scheduler.h"
 #include "esc_telemetry.h"
+#include "dshot_capture.h"
 #include "uart.h"
 #include "stm32f4xx.h"
 #include <stdbool.h>
 
+/* Longest wait for the motor to go idle before a speed change */
+#define SPEED_CHANGE_TIMEOUT_US 10000
+
 /* Delay function (busy wait) */
 static void delay_ms(uint32_t ms) {
     /* Approximate delay at 168MHz */
@@ -57,20 +64,21 @@ void system_clock_init(void) {
 void esc_arm_sequence(void) {
     uart_puts("\r\n=== ESC Arming Sequence ===\r\n");
 
-    /* Send zero throttle for a period */
+    /* Send zero throttle for a period (frames are sent by the scheduler) */
     uart_puts("Sending zero throttle...\r\n");
-    for (int i = 0; i < 100; i++) {
-        dshot_send_throttle(0);
-        esc_telemetry_update();
-        delay_ms(10);
-    }
+    dshot_scheduler_set_throttle(0, 0);
+    dshot_scheduler_start(DSHOT_SCHED_DEFAULT_RATE);
+    delay_ms(1000);
 
     /* Optional: Send beep command to confirm ESC is responding */
     uart_puts("Sending beep command...\r\n");
-    for (int i = 0; i < 10; i++) {
-        dshot_send_command(DSHOT_CMD_BEEP1);
-        delay_ms(10);
-    }
+    dshot_scheduler_send_command(0, DSHOT_CMD_BEEP1);
+
+#if ESC_TELEMETRY_EDT
+    /* Ask for temperature/voltage/current on the signal wire */
+    uart_puts("Enabling extended telemetry (EDT)...\r\n");
+    esc_telemetry_enable_edt();
+#endif
 
     delay_ms(500);
     uart_puts("ESC armed and ready!\r\n\r\n");
@@ -84,13 +92,56 @@ void display_telemetry_stats(void) {
 
     uart_puts("\r\n--- Telemetry Statistics ---\r\n");
     uart_printf("Frames sent:     %u\r\n", telem->frame_count);
-    uart_printf("Successful:      %u\r\n", telem->success_count);
+    uart_printf("Successful:      %u (+%u EDT)\r\n", telem->success_count, telem->edt_count);
     uart_printf("Errors:          %u\r\n", telem->error_count);
 
     if (telem->frame_count > 0) {
-        uint32_t success_rate = (telem->success_count * 100) / telem->frame_count;
+        uint32_t success_rate = ((telem->success_count + telem->edt_count) * 100) / telem->frame_count;
         uart_printf("Success rate:    %u%%\r\n", success_rate);
     }
+    uart_printf("Link quality:    %u%% (last %u frames)\r\n", telem->link_quality, telem->lq_frames);
+    uart_printf("  Timeout %u, edges %u, bits %u, GCR %u, CRC %u\r\n",
+               telem->errors[DSHOT_TELEM_ERR_TIMEOUT], telem->errors[DSHOT_TELEM_ERR_EDGES],
+               telem->errors[DSHOT_TELEM_ERR_BITS], telem->errors[DSHOT_TELEM_ERR_GCR],
+               telem->errors[DSHOT_TELEM_ERR_CRC]);
+
+    if (telem->success_count > 0) {
+        uart_printf("Sample age:      %u us (latency %u us)\r\n",
+                   dshot_telem_age_us(telem), dshot_telem_latency_us(telem));
+    }
+
+#if DSHOT_HEALTH
+    uint8_t faults = dshot_scheduler_get_faults(0);
+    uart_printf("Motor faults:    %s%s%s%s\r\n", faults ? "" : "none",
+               (faults & DSHOT_HEALTH_STALL) ? "stall " : "",
+               (faults & DSHOT_HEALTH_DESYNC) ? "desync " : "",
+               (faults & DSHOT_HEALTH_COLLAPSE) ? "collapse" : "");
+#endif
+
+    dshot_decode_stats_t decode;
+    dshot_get_decode_stats(&decode);
+    if (decode.count > 0) {
+        uart_printf("Decode cycles:   avg %u, max %u (%u decodes)\r\n",
+                   decode.avg_cycles, decode.max_cycles, decode.count);
+    }
+
+    esc_telemetry_t* esc = esc_telemetry_get();
+    if (esc->edt_valid) {
+        uart_printf("ESC temp:        %u C\r\n", esc->temperature);
+        uart_printf("ESC voltage:     %u.%u V\r\n", esc->voltage / 100, (esc->voltage % 100) / 10);
+        uart_printf("ESC current:     %u A\r\n", esc->current / 100);
+        uart_printf("ESC stress:      %u (status 0x%x)\r\n", esc->stress, esc->status);
+    }
+
+    if (dshot_scheduler_running()) {
+        dshot_scheduler_stats_t sched;
+        dshot_scheduler_get_stats(&sched);
+        uart_printf("Frame rate:      %u Hz\r\n", sched.rate_hz);
+        uart_printf("Frames armed:    %u (busy skips: %u)\r\n", sched.frames_sent, sched.busy_skips);
+        uart_printf("Command frames:  %u\r\n", sched.commands_sent);
+        uart_printf("Interval:        %u-%u ns\r\n", sched.interval_min_ns, sched.interval_max_ns);
+        uart_printf("Max jitter:      %u ns\r\n", sched.jitter_max_ns);
+    }
     uart_puts("----------------------------\r\n\r\n");
 }
 
@@ -117,19 +168,22 @@ void motor_test_cycle(void) {
 
         uart_printf("Throttle: %u\r\n", throttle);
 
-        /* Run at this throttle for ~1 second */
+        /* Run at this throttle for ~1 second (frames are sent by the scheduler) */
+        dshot_scheduler_set_throttle(0, throttle);
         for (int i = 0; i < 50; i++) {
-            dshot_send_throttle(throttle);
             esc_telemetry_update();
 
             /* Check for telemetry data */
             if (esc_telemetry_available()) {
                 dshot_telemetry_t* telem = dshot_get_telemetry();
-                uart_printf("  RPM: %u (eRPM: %u, period: %u us)\r\n",
-                           telem->rpm, telem->erpm, telem->period_us);
+                uart_printf("  RPM: %u (eRPM: %u, filtered %u, period: %u us)\r\n",
+                           telem->rpm, telem->erpm, telem->erpm_filtered, telem->period_us);
+#if DSHOT_ERPM_MOTION
+                uart_printf("  Accel: %d RPM/s\r\n", telem->rpm_accel);
+#endif
             }
 
-            delay_ms(20);  /* 50Hz update rate */
+            delay_ms(20);  /* 50Hz display rate */
         }
 
         delay_ms(500);
@@ -138,15 +192,40 @@ void motor_test_cycle(void) {
     /* Ramp back down to zero */
     uart_puts("\r\nRamping down...\r\n");
     for (int throttle = DSHOT_THROTTLE_MIN + 500; throttle >= DSHOT_THROTTLE_MIN; throttle -= 50) {
+        dshot_scheduler_set_throttle(0, throttle);
+        delay_ms(100);
+    }
+
+    display_telemetry_stats();
+    uart_puts("Test cycle complete!\r\n\r\n");
+}
+
+/**
+ * @brief Hold a series of RPM setpoints with the governor
+ */
+void motor_governor_test(void) {
+    static const uint32_t test_rpm[] = { 3000, 6000, 9000, 6000, 3000 };
+    const uint16_t fallback = DSHOT_THROTTLE_MIN + 100;  /* Open loop if telemetry drops */
+    static dshot_telemetry_t telem;     /* Snapshot, kept between reads */
+
+    uart_puts("\r\n=== RPM Governor Test ===\r\n");
+    uart_puts("WARNING: Remove propellers before testing!\r\n\r\n");
+
+    for (unsigned step = 0; step < sizeof(test_rpm) / sizeof(test_rpm[0]); step++) {
+        uart_printf("Setpoint: %u RPM\r\n", test_rpm[step]);
+        dshot_scheduler_set_rpm(0, test_rpm[step], fallback);
+
         for (int i = 0; i < 10; i++) {
-            dshot_send_throttle(throttle);
-            esc_telemetry_update();
-            delay_ms(10);
+            delay_ms(200);
+            dshot_motor_read_telemetry(0, &telem);  /* The receive interrupt keeps writing */
+            uart_printf("  RPM: %u (%s)\r\n", telem.erpm_filtered * 2 / MOTOR_POLES,
+                       dshot_scheduler_governor_engaged(0) ? "closed loop" : "open loop");
         }
     }
 
+    dshot_scheduler_set_throttle(0, DSHOT_THROTTLE_MIN);
     display_telemetry_stats();
-    uart_puts("Test cycle complete!\r\n\r\n");
+    uart_puts("Governor test complete!\r\n\r\n");
 }
 
 /**
@@ -160,16 +239,19 @@ void interactive_mode(void) {
     uart_puts("Commands:\r\n");
     uart_puts("  +: Increase throttle by 50\r\n");
     uart_puts("  -: Decrease throttle by 50\r\n");
-    uart_puts("  0: Stop motor\r\n");
+    uart_puts("  0: Stop motor (clears motor faults)\r\n");
     uart_puts("  b: Send beep command\r\n");
+    uart_puts("  p: Step protocol speed (150/300/600/1200)\r\n");
     uart_puts("  t: Run test cycle\r\n");
+    uart_puts("  g: Run RPM governor test\r\n");
     uart_puts("  s: Show statistics\r\n");
+    uart_puts("  d: Dump logged telemetry captures (binary)\r\n");
     uart_puts("  h: Show this help\r\n");
     uart_puts("\r\nReady for commands...\r\n\r\n");
 
     while (1) {
-        /* Send current throttle command */
-        dshot_send_throttle(current_throttle);
+        /* Command current throttle (sent by the scheduler at its own rate) */
+        dshot_scheduler_set_throttle(0, current_throttle);
 
         /* Process bidirectional telemetry */
         esc_telemetry_update();
@@ -217,17 +299,40 @@ void interactive_mode(void) {
 
                 case '0':
                     current_throttle = DSHOT_THROTTLE_MIN;
+                    dshot_scheduler_clear_faults(0);
                     uart_puts("Motor stopped\r\n");
                     break;
 
                 case 'b':
-                    uart_puts("Sending beep...\r\n");
-                    for (int i = 0; i < 10; i++) {
-                        dshot_send_command(DSHOT_CMD_BEEP1);
-                        delay_ms(10);
+                    if (dshot_scheduler_send_command(0, DSHOT_CMD_BEEP1)) {
+                        uart_puts("Beep queued\r\n");
+                    } else {
+                        uart_puts("Command queue full\r\n");
                     }
                     break;
 
+                case 'p': {
+                    uint16_t speed = dshot_get_speed();
+                    speed = (speed >= 1200) ? 150 : speed * 2;
+                    dshot_scheduler_stop();
+                    delay_ms(1);  /* Let the frame in flight finish */
+                    uint32_t wait_start = dshot_time_now();
+                    bool idle;
+                    while (!(idle = dshot_ready()) &&
+                           dshot_time_now() - wait_start < SPEED_CHANGE_TIMEOUT_US * DSHOT_TIME_TICKS_PER_US) {
+                        dshot_update();  /* A stuck stream must not hang the UI */
+                    }
+                    if (!idle) {
+                        uart_puts("Speed change failed: motor still busy\r\n");
+                    } else if (dshot_set_speed(speed)) {
+                        uart_printf("Protocol speed: DShot%u\r\n", speed);
+                    } else {
+                        uart_puts("Speed change failed\r\n");
+                    }
+                    dshot_scheduler_start(DSHOT_SCHED_DEFAULT_RATE);
+                    break;
+                }
+
                 case 't':
                     motor_test_cycle();
                     current_throttle = DSHOT_THROTTLE_MIN;
@@ -237,8 +342,21 @@ void interactive_mode(void) {
                     display_telemetry_stats();
                     break;
 
+                case 'g':
+                    motor_governor_test();
+                    current_throttle = DSHOT_THROTTLE_MIN;
+                    break;
+
+                case 'd': {
+                    /* Binary dump for tools/dshot_replay.c, framed by text lines */
+                    uart_puts("--- capture dump ---\r\n");
+                    uint8_t n = dshot_capture_dump(uart_putc);
+                    uart_printf("\r\n--- %u captures ---\r\n", n);
+                    break;
+                }
+
                 case 'h':
-                    uart_puts("Commands: +/- (throttle), 0 (stop), b (beep), t (test), s (stats), h (help)\r\n");
+                    uart_puts("Commands: +/- (throttle), 0 (stop), b (beep), p (speed), t (test), g (governor), s (stats), d (dump captures), h (help)\r\n");
                     break;
 
                 default:
@@ -247,7 +365,7 @@ void interactive_mode(void) {
             }
         }
 
-        delay_ms(20);  /* 50Hz update rate */
+        delay_ms(20);  /* 50Hz UI/display rate */
     }
 }
 
@@ -285,8 +403,8 @@ int main(void) {
     }
     uart_puts("Telemetry ready (bidirectional on signal wire).\r\n");
 
-    uart_puts("\r\nNOTE: With bidirectional DShot, only RPM data is\r\n");
-    uart_puts("available. Voltage/current/temp require serial telemetry.\r\n");
+    uart_puts("\r\nNOTE: Voltage/current/temp need an ESC with Extended\r\n");
+    uart_puts("DShot Telemetry (EDT); otherwise only RPM is available.\r\n");
 
     delay_ms(1000);
 
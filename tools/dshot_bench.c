@@ -0,0 +1,1033 @@
+/**
+ * @file dshot_bench.c
+ * @brief Host benchmark for the telemetry edge decoders
+ *
+ * Builds a set of captured edge timestamps from random valid telemetry
+ * frames (with edge jitter and random timer start values so the 16-bit
+ * wrap is exercised), checks that the table-driven decoder returns the
+ * same bits as the reference loop on every capture, then times both.
+ *
+ * A second pass generates captures from ESCs whose clock is off by up to
+ * 18% and compares the frame error rate of a fixed bit period with the
+ * adaptive receive clock estimate (dshot_rx_scale_update()); the adaptive
+ * decoder must lose fewer frames wherever the fixed one loses any.
+ *
+ * Every capture is built by a reference encoder (eee mmmmmmmmm value,
+ * inverted CRC, GCR, transition encoding) and must decode back to the
+ * same period; a short list of known line words is checked first.
+ *
+ * The eRPM conversion backend (dshot_erpm_from_value()) is checked
+ * against the exact division over the whole 12-bit value domain, EDT
+ * codes and the stopped value included, and the two are timed.
+ *
+ * The eRPM filter (dshot_filter.h) must pass a constant, reject a single
+ * spike and attenuate a sine at its cutoff as documented for
+ * dshot_erpm_filter_config(): at fc = fs / 10 the discretised stages read
+ * 0.62 (PT1) / 0.56 (PT2) instead of the analog 0.71, and the median costs
+ * a little more (it alone reads about 0.95); its cost per sample is timed. Raising the order at runtime must not pull
+ * the output towards 0. The acceleration/jerk estimate is checked
+ * against synthetic ramps (linear with timestamp jitter, quadratic,
+ * timer wrap, telemetry gap) and saturating steps, including the RPM
+ * conversion of a saturated rate.
+ *
+ * EDT frames interleaved with eRPM frames must not reach the filter or
+ * the motion estimate, nor count as new samples.
+ *
+ * The RPM governor (dshot_governor.h) is run against a first-order motor
+ * model with a load step and an unreachable setpoint (windup).
+ *
+ * The stall / desync detector (dshot_health.h) must stay quiet through a
+ * noisy flight-like throttle profile with outlier frames and hard braking,
+ * and flag an injected stall, collapse and slow underspeed; detection
+ * latency is printed. A governed motor cut by the detector must restart
+ * from its fallback throttle once the fault is cleared.
+ *
+ * Build and run with `make bench`.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dshot_proto.h"
+#include "dshot_filter.h"
+#include "dshot_governor.h"
+#include "dshot_health.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+#define BENCH_CAPTURES      4096        /* Distinct edge sets */
+#define BENCH_PASSES        512         /* Decodes per set per decoder */
+#define BENCH_MAX_EDGES     32
+#define BENCH_JITTER_PCT    10          /* Edge jitter, +/- percent of a bit */
+#define BENCH_DRIFT_FRAMES  4096        /* Frames per ESC clock drift case */
+#define BENCH_ERPM_PASSES   2048        /* Sweeps of the 12-bit domain per backend */
+#define BENCH_FILTER_SAMPLES (1 << 22)  /* Samples timed per filter order */
+#define BENCH_TIME_HZ       168000000UL /* Telemetry time base (DWT at 168MHz) */
+
+typedef struct {
+    uint16_t edges[BENCH_MAX_EDGES];
+    uint8_t  count;
+} capture_t;
+
+static capture_t captures[BENCH_CAPTURES];
+
+/* 4-bit nibble -> 5-bit GCR symbol (inverse of the decoder table) */
+static const uint8_t gcr_encode_table[16] = {
+    0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17,
+    0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F,
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void) {
+#ifdef BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* Known responses: line word (line low = 1) -> 12-bit value */
+static const struct {
+    uint32_t line;
+    uint16_t value;
+    uint32_t period_us;
+    uint32_t erpm;
+} golden[] = {
+    { 0x175272, 0x0C8, 200,    300000 },    /* 200us, exponent 0 */
+    { 0x113A26, 0x390, 800,    75000 },     /* Exponent 1, normalized mantissa 400 */
+    { 0x16D6B4, 0x1FF, 511,    117417 },
+    { 0x1745B4, 0x001, 1,      60000000 },
+    { 0x1AD692, 0xFFE, 65280,  919 },       /* Longest running period */
+    { 0x1AD6AE, 0xFFF, 65408,  0 },         /* Motor stopped */
+};
+
+/**
+ * @brief Build the 21-bit line word for a 12-bit eee mmmmmmmmm value
+ */
+static uint32_t make_response(uint16_t value) {
+    uint16_t crc = ~(value ^ (value >> 4) ^ (value >> 8)) & 0x0F;
+    uint16_t word = (value << 4) | crc;
+    uint32_t gcr = 0;
+    uint32_t line = 1;  /* Start bit pulls the line low */
+
+    for (int i = 3; i >= 0; i--) {
+        gcr = (gcr << 5) | gcr_encode_table[(word >> (i * 4)) & 0x0F];
+    }
+
+    /* Each GCR '1' toggles the line */
+    for (int bit = 19; bit >= 0; bit--) {
+        line = (line << 1) | ((line & 1) ^ ((gcr >> bit) & 1));
+    }
+
+    return line;
+}
+
+static uint32_t expected_period(uint16_t value) {
+    return (uint32_t)(value & 0x1FF) << (value >> 9);
+}
+
+/**
+ * @brief Turn a response word into edge timestamps (line low = 1)
+ * @param bit_period_q8 Actual ESC bit period in 1/256 timer ticks
+ */
+static void make_capture(capture_t *c, uint32_t raw, uint32_t bit_period_q8) {
+    uint32_t t = (uint32_t)(rand() & 0xFFFF) << 8;
+    int level = 1;
+    int run = 0;
+    int jitter = bit_period_q8 * BENCH_JITTER_PCT / 100;
+
+    c->count = 0;
+
+    /* Skip leading idle bits: capture starts at the first falling edge */
+    int bit = DSHOT_TELEM_FRAME_BITS - 1;
+    while (bit >= 0 && !((raw >> bit) & 1)) {
+        bit--;
+    }
+
+    c->edges[c->count++] = (uint16_t)(t >> 8);
+    for (; bit >= 0; bit--) {
+        int b = (raw >> bit) & 1;
+        if (b != level) {
+            int j = jitter ? (rand() % (2 * jitter + 1)) - jitter : 0;
+            t += run * bit_period_q8 + j;
+            c->edges[c->count++] = (uint16_t)(t >> 8);
+            level = b;
+            run = 0;
+        }
+        run++;
+    }
+    if (level == 1) {
+        /* Line returns to idle after the last low run */
+        t += run * bit_period_q8;
+        c->edges[c->count++] = (uint16_t)(t >> 8);
+    }
+}
+
+/**
+ * @brief Random eRPM value (normalized, so never an EDT frame)
+ */
+static uint16_t random_erpm_value(void) {
+    uint16_t value = rand() & 0x0FFF;
+
+    return DSHOT_EDT_IS_EXTENDED(value) ? (value | 0x0100) : value;
+}
+
+/**
+ * @brief Decode one capture and check it against the value it was built from
+ */
+static bool decode_ok(const dshot_edge_table_t *table, const capture_t *c,
+                      uint32_t scale_q16, uint16_t value) {
+    dshot_telemetry_t telem;
+    uint32_t bits;
+    uint8_t n = dshot_edges_to_bits_table(table, c->edges, c->count, scale_q16, &bits);
+
+    if (n < DSHOT_TELEM_MIN_BITS) {
+        return false;
+    }
+    bits <<= DSHOT_TELEM_FRAME_BITS - n;
+    return dshot_decode_gcr_frame(bits, &telem) == DSHOT_TELEM_OK &&
+           telem.period_us == expected_period(value);
+}
+
+/**
+ * @brief Check the known responses and the encoder/decoder round trip
+ * @return Number of failures
+ */
+static int check_decode(void) {
+    int failures = 0;
+
+    for (unsigned i = 0; i < sizeof(golden) / sizeof(golden[0]); i++) {
+        dshot_telemetry_t telem;
+
+        memset(&telem, 0, sizeof(telem));
+        if (make_response(golden[i].value) != golden[i].line ||
+            dshot_decode_gcr_frame(golden[i].line, &telem) != DSHOT_TELEM_OK ||
+            telem.period_us != golden[i].period_us || telem.erpm != golden[i].erpm) {
+            printf("GOLDEN %u (value %03x) failed\n", i, golden[i].value);
+            failures++;
+        }
+        /* Any single bit error must be rejected */
+        for (int bit = 0; bit < DSHOT_TELEM_FRAME_BITS; bit++) {
+            if (dshot_decode_gcr_frame(golden[i].line ^ (1UL << bit), &telem) == DSHOT_TELEM_OK) {
+                printf("GOLDEN %u accepted with bit %d flipped\n", i, bit);
+                failures++;
+            }
+        }
+    }
+
+    for (uint32_t value = 0; value < 0x1000; value++) {
+        dshot_telemetry_t telem;
+        bool ok;
+
+        memset(&telem, 0, sizeof(telem));
+        dshot_telem_result_t result = dshot_decode_gcr_frame(make_response(value), &telem);
+        if (DSHOT_EDT_IS_EXTENDED(value)) {
+            /* EDT frames leave eRPM alone and land in their own field */
+            ok = result == DSHOT_TELEM_EDT && telem.period_us == 0 &&
+                 telem.edt.received == DSHOT_EDT_BIT(value & DSHOT_EDT_TYPE_MASK);
+        } else {
+            ok = result == DSHOT_TELEM_OK && telem.period_us == expected_period(value) && !telem.edt.received;
+        }
+        if (!ok) {
+            if (failures < 10) {
+                printf("ROUND TRIP %03x failed\n", value);
+            }
+            failures++;
+        }
+    }
+
+    printf("%u known responses, 4096 round trips: %s\n\n",
+           (unsigned)(sizeof(golden) / sizeof(golden[0])), failures ? "FAILED" : "ok");
+    return failures;
+}
+
+/**
+ * @brief Check the eRPM backend against the division over every value, then time both
+ *
+ * All 4096 values are converted: the 2303 normalized eRPM encodings, the
+ * non-normalized periods that share their codes with EDT frames and the
+ * zero mantissas. Each is also sent through the frame decoder, which must
+ * publish the converted eRPM for an eRPM frame, 0 for DSHOT_TELEM_STOPPED
+ * and leave the eRPM fields alone for an EDT frame. Only eRPM encodings
+ * are timed.
+ *
+ * @return Number of values outside the documented bound or decoded otherwise
+ */
+static int check_erpm(void) {
+    static uint16_t values[0x1000];
+    int count = 0, aliases = 0, differ = 0, differ_edt = 0, failures = 0;
+    double max_err = 0.0;
+
+    for (uint32_t value = 0; value < 0x1000; value++) {
+        dshot_telemetry_t telem;
+        bool extended = DSHOT_EDT_IS_EXTENDED(value);
+
+        if (value != DSHOT_TELEM_STOPPED && !extended) {
+            values[count++] = value;
+        } else {
+            aliases++;
+        }
+
+        uint32_t period = expected_period(value);
+        uint32_t exact = dshot_erpm_from_period(period);
+        uint32_t fast = dshot_erpm_from_value(value);
+        double err = period ? (double)fast - 60000000.0 / period : (double)fast;
+
+        if (err < 0) {
+            err = -err;
+        }
+
+        if (fast != exact) {
+            if (extended) {
+                differ_edt++;   /* Never converted by the receive path */
+            } else {
+                differ++;
+            }
+        }
+        if (err > max_err) {
+            max_err = err;
+        }
+
+        /* What the receive path publishes for this value */
+        memset(&telem, 0, sizeof(telem));
+        telem.erpm = 0xDEADBEEF;
+        bool decoded = dshot_decode_gcr_frame(make_response(value), &telem) ==
+                       (extended ? DSHOT_TELEM_EDT : DSHOT_TELEM_OK);
+        uint32_t published = extended ? 0xDEADBEEF : (value == DSHOT_TELEM_STOPPED) ? 0 : fast;
+
+        if (err >= 0.51 || fast + 1 < exact || fast > exact + 1 || !decoded || telem.erpm != published) {
+            if (failures < 10) {
+                printf("ERPM %03x: table %u, division %u, decoded %u\n", value, fast, exact, telem.erpm);
+            }
+            failures++;
+        }
+    }
+
+    volatile uint32_t sink = 0;
+    uint64_t total = (uint64_t)count * BENCH_ERPM_PASSES;
+    uint64_t t0, c0, div_ns, div_cyc, tab_ns, tab_cyc;
+
+    t0 = now_ns();
+    c0 = now_cycles();
+    for (int p = 0; p < BENCH_ERPM_PASSES; p++) {
+        for (int i = 0; i < count; i++) {
+            sink += dshot_erpm_from_period(expected_period(values[i]));
+        }
+    }
+    div_cyc = now_cycles() - c0;
+    div_ns = now_ns() - t0;
+
+    t0 = now_ns();
+    c0 = now_cycles();
+    for (int p = 0; p < BENCH_ERPM_PASSES; p++) {
+        for (int i = 0; i < count; i++) {
+            sink += dshot_erpm_from_value(values[i]);
+        }
+    }
+    tab_cyc = now_cycles() - c0;
+    tab_ns = now_ns() - t0;
+    (void)sink;
+
+    printf("eRPM conversion over 4096 values (%d eRPM, %d EDT/stopped): %d of %d eRPM values "
+           "(plus %d EDT) differ from rounded division, max error %.3f eRPM: %s\n",
+           count, aliases, differ, count, differ_edt, max_err, failures ? "FAILED" : "ok");
+    printf("%-10s %10s %12s\n", "backend", "ns/value", "cycles/value");
+    printf("%-10s %10.2f %12.1f\n", "division", (double)div_ns / total, (double)div_cyc / total);
+    printf("%-10s %10.2f %12.1f\n\n", DSHOT_ERPM_TABLE ? "table" : "division", (double)tab_ns / total, (double)tab_cyc / total);
+    return failures;
+}
+
+/**
+ * @brief Check the eRPM filter response for every order, then time it
+ * @return Number of failed checks
+ */
+static int check_filter(void) {
+    const uint16_t rate = DSHOT_ERPM_FILTER_RATE_HZ, cutoff = rate / 10;  /* Gains below are for fs / 10 */
+    int failures = 0;
+
+    printf("eRPM filter, cutoff %u Hz at %u Hz\n", cutoff, rate);
+    printf("%-6s %8s %8s %10s %10s %12s\n", "order", "const", "spike", "gain@fc", "ns/sample", "cycles/sample");
+
+    for (uint8_t order = 0; order <= DSHOT_ERPM_FILTER_MAX_ORDER; order++) {
+        dshot_erpm_filter_config_t config;
+        dshot_erpm_filter_t filter;
+        bool const_ok = true, spike_ok = true;
+
+        dshot_erpm_filter_config(&config, order, cutoff, rate);
+
+        /* Constant input passes exactly, a single outlier never shows */
+        dshot_erpm_filter_reset(&filter);
+        for (int n = 0; n < 1000; n++) {
+            uint32_t out = dshot_erpm_filter_apply(&filter, &config, (n == 500) ? 60000 : 20000);
+            if (out != 20000) {
+                if (n == 500) {
+                    spike_ok = false;
+                } else {
+                    const_ok = false;
+                }
+            }
+        }
+
+        /* Steady-state amplitude of a sine at the cutoff */
+        const double two_pi = 6.283185307179586;
+        double peak = 0.0;
+        dshot_erpm_filter_reset(&filter);
+        for (int n = 0; n < 20 * rate / cutoff; n++) {
+            double phase = two_pi * cutoff * n / rate;
+            double s = phase - two_pi * (int)(phase / two_pi);
+            /* sin() without -lm: Bhaskara approximation per half period */
+            double sign = (s < two_pi / 2) ? 1.0 : -1.0;
+            double h = (s < two_pi / 2) ? s : s - two_pi / 2;
+            double sine = sign * 16.0 * h * (two_pi / 2 - h) /
+                          (5.0 * (two_pi / 2) * (two_pi / 2) - 4.0 * h * (two_pi / 2 - h));
+            uint32_t out = dshot_erpm_filter_apply(&filter, &config, (uint32_t)(20000 + 5000 * sine));
+
+            if (n >= 10 * rate / cutoff) {
+                double a = (double)out - 20000.0;
+                if (a < 0) {
+                    a = -a;
+                }
+                if (a > peak) {
+                    peak = a;
+                }
+            }
+        }
+        double gain = peak / 5000.0;
+
+        volatile uint32_t sink = 0;
+        uint64_t t0 = now_ns(), c0 = now_cycles();
+        dshot_erpm_filter_reset(&filter);
+        for (uint32_t n = 0; n < BENCH_FILTER_SAMPLES; n++) {
+            sink += dshot_erpm_filter_apply(&filter, &config, 20000 + (n & 0xFF));
+        }
+        uint64_t cyc = now_cycles() - c0, ns = now_ns() - t0;
+        (void)sink;
+
+        /* See dshot_erpm_filter_config() */
+        static const double gain_expected[] = { 0.95, 0.59, 0.56 };
+        bool gain_ok = gain > gain_expected[order] - 0.02 && gain < gain_expected[order] + 0.02;
+        if (!const_ok || !spike_ok || !gain_ok) {
+            failures++;
+        }
+        printf("%-6u %8s %8s %10.3f %10.2f %12.1f\n", order, const_ok ? "ok" : "FAILED",
+               spike_ok ? "ok" : "FAILED", gain, (double)ns / BENCH_FILTER_SAMPLES,
+               (double)cyc / BENCH_FILTER_SAMPLES);
+    }
+
+    /* Raising the order at runtime must not restart the new stages from 0 */
+    static const uint8_t orders[] = { 0, 1, 2, 0, 2 };
+    dshot_erpm_filter_t filter;
+    uint32_t worst = 20000;
+    dshot_erpm_filter_reset(&filter);
+    for (unsigned step = 0; step < sizeof(orders); step++) {
+        dshot_erpm_filter_config_t config;
+
+        dshot_erpm_filter_config(&config, orders[step], cutoff, rate);
+        for (int n = 0; n < 100; n++) {
+            uint32_t out = dshot_erpm_filter_apply(&filter, &config, 20000);
+            if (out < worst) {
+                worst = out;
+            }
+        }
+    }
+    printf("Order changes 0-1-2-0-2 at constant input: lowest output %u: %s\n\n",
+           worst, worst == 20000 ? "ok" : "FAILED");
+    failures += worst != 20000;
+
+    return failures;
+}
+
+/**
+ * @brief Check the acceleration/jerk estimate against synthetic ramps, then time it
+ * @return Number of failed checks
+ */
+static int check_motion(void) {
+    dshot_erpm_motion_t motion;
+    int failures = 0;
+
+    /* Linear ramp of 1e6 eRPM/s at 8kHz, +/-10% timestamp jitter, across the timer wrap */
+    const double accel = 1e6;
+    const uint32_t dt = BENCH_TIME_HZ / 8000;
+    uint32_t time = 0xFFFFFFFFu - 100 * dt;
+    double t = 0.0, max_err = 0.0;
+
+    dshot_erpm_motion_reset(&motion);
+    for (int n = 0; n < 1000; n++) {
+        uint32_t step = dt - dt / 10 + (uint32_t)(rand() % (dt / 5));
+
+        time += step;
+        t += (double)step / BENCH_TIME_HZ;
+        dshot_erpm_motion_update(&motion, (uint32_t)(10000.0 + accel * t + 0.5), time, BENCH_TIME_HZ);
+        if (n > 0) {
+            double err = ((double)motion.accel - accel) / accel;
+            err = (err < 0) ? -err : err;
+            if (err > max_err) {
+                max_err = err;
+            }
+        }
+    }
+    bool linear_ok = max_err < 0.02;
+
+    /* Quadratic 10000 + 3n^2 at 1ms: backward differences are exact,
+     * accel = 3(2n - 1) eRPM/ms, jerk = 6 eRPM/ms^2 */
+    bool quad_ok = true;
+    time = 12345;
+    dshot_erpm_motion_reset(&motion);
+    for (int n = 0; n < 200; n++) {
+        dshot_erpm_motion_update(&motion, 10000 + 3 * n * n, time, BENCH_TIME_HZ);
+        time += BENCH_TIME_HZ / 1000;
+        if ((n >= 1 && motion.accel != 3 * (2 * n - 1) * 1000) ||
+            (n >= 2 && motion.jerk != 6 * 1000 * 1000)) {
+            quad_ok = false;
+        }
+    }
+
+    /* A gap longer than DSHOT_ERPM_MOTION_MAX_GAP_MS restarts the estimate */
+    time += BENCH_TIME_HZ / 1000 * (DSHOT_ERPM_MOTION_MAX_GAP_MS + 1);
+    dshot_erpm_motion_update(&motion, 90000, time, BENCH_TIME_HZ);
+    bool gap_ok = motion.accel == 0 && motion.jerk == 0;
+
+    /* Steps of 40 eRPM in one 8kHz sample saturate the jerk both ways; the
+     * RPM conversion must keep the sign and magnitude */
+    bool sat_ok = true;
+    static const uint32_t steps[] = { 10000, 10000, 10040, 10000 };
+    static const int32_t jerk_sat[] = { 0, 0, INT32_MAX, INT32_MIN };
+    time = 777;
+    dshot_erpm_motion_reset(&motion);
+    for (int n = 0; n < 4; n++) {
+        dshot_erpm_motion_update(&motion, steps[n], time, BENCH_TIME_HZ);
+        time += dt;
+        int32_t rpm_jerk = dshot_rpm_rate_from_erpm(motion.jerk);
+        if (motion.jerk != jerk_sat[n] || rpm_jerk != jerk_sat[n] / (MOTOR_POLES / 2) ||
+            (jerk_sat[n] > 0 && rpm_jerk <= 0) || (jerk_sat[n] < 0 && rpm_jerk >= 0)) {
+            sat_ok = false;
+        }
+    }
+
+    volatile int32_t sink = 0;
+    uint64_t t0 = now_ns(), c0 = now_cycles();
+    dshot_erpm_motion_reset(&motion);
+    for (uint32_t n = 0; n < BENCH_FILTER_SAMPLES; n++) {
+        dshot_erpm_motion_update(&motion, 20000 + (n & 0xFF), n * dt, BENCH_TIME_HZ);
+        sink += motion.jerk;
+    }
+    uint64_t cyc = now_cycles() - c0, ns = now_ns() - t0;
+    (void)sink;
+
+    failures = !linear_ok + !quad_ok + !gap_ok + !sat_ok;
+    printf("Motion estimate: linear ramp max error %.2f%% %s, quadratic %s, gap restart %s, saturation %s\n",
+           100.0 * max_err, linear_ok ? "ok" : "FAILED", quad_ok ? "ok" : "FAILED", gap_ok ? "ok" : "FAILED",
+           sat_ok ? "ok" : "FAILED");
+    printf("%.2f ns / %.1f cycles per sample\n\n", (double)ns / BENCH_FILTER_SAMPLES,
+           (double)cyc / BENCH_FILTER_SAMPLES);
+    return failures;
+}
+
+/**
+ * @brief Decode, account and filter one response like the receive paths do
+ * @return true if it was a new eRPM sample
+ */
+static bool receive_frame(dshot_telemetry_t *telem, dshot_erpm_filter_t *filter,
+                          const dshot_erpm_filter_config_t *config, dshot_erpm_motion_t *motion,
+                          uint16_t value, uint32_t time, dshot_telem_result_t *result) {
+    *result = dshot_decode_gcr_frame(make_response(value), telem);
+    dshot_telem_account(telem, *result);
+    return dshot_erpm_sample(telem, *result, filter, config, motion, time, BENCH_TIME_HZ);
+}
+
+/**
+ * @brief Check that EDT frames between eRPM frames are not taken as samples
+ *
+ * An accelerating motor at 1kHz with every other frame replaced by an
+ * EDT frame: each EDT frame must leave erpm_filtered, rpm_accel,
+ * rpm_jerk and the sample count unchanged while its own field and the
+ * link quality update.
+ *
+ * @return Number of failed checks
+ */
+static int check_edt(void) {
+    dshot_erpm_filter_config_t config;
+    dshot_erpm_filter_t filter;
+    dshot_erpm_motion_t motion;
+    dshot_telemetry_t telem;
+    dshot_telem_result_t result;
+    uint32_t time = 4242;
+    int samples = 0, edt_frames = 0, failures = 0;
+
+    dshot_erpm_filter_config(&config, DSHOT_ERPM_FILTER_ORDER, DSHOT_ERPM_FILTER_CUTOFF_HZ,
+                             DSHOT_ERPM_FILTER_RATE_HZ);
+    dshot_erpm_filter_reset(&filter);
+    dshot_erpm_motion_reset(&motion);
+    dshot_telem_reset(&telem);
+
+    for (int n = 0; n < 200; n++) {
+        time += BENCH_TIME_HZ / 1000;
+
+        if (n % 2 == 0) {
+            /* Period shrinking from 400us: eRPM rising */
+            uint16_t value = 400 - n;
+            bool fresh = receive_frame(&telem, &filter, &config, &motion, value, time, &result);
+
+            if (!fresh || result != DSHOT_TELEM_OK) {
+                failures++;
+            }
+            samples++;
+            continue;
+        }
+
+        uint32_t filtered = telem.erpm_filtered, erpm = telem.erpm, success = telem.success_count;
+        int32_t accel = telem.rpm_accel, jerk = telem.rpm_jerk;
+        uint8_t temperature = (uint8_t)(20 + n / 10);
+        bool fresh = receive_frame(&telem, &filter, &config, &motion,
+                                   DSHOT_EDT_TEMPERATURE | temperature, time, &result);
+
+        edt_frames++;
+        if (fresh || result != DSHOT_TELEM_EDT || telem.erpm_filtered != filtered ||
+            telem.erpm != erpm || telem.rpm_accel != accel || telem.rpm_jerk != jerk ||
+            telem.success_count != success || telem.edt.temperature != temperature) {
+            if (failures < 10) {
+                printf("EDT frame %d changed the eRPM sample\n", n);
+            }
+            failures++;
+        }
+    }
+
+    /* The estimate saw 2ms steps only, so the accelerating motor reads positive */
+    if (telem.rpm_accel <= 0 || telem.success_count != (uint32_t)samples ||
+        telem.edt_count != (uint32_t)edt_frames || telem.error_count != 0 || telem.link_quality != 100) {
+        failures++;
+    }
+
+    printf("EDT interleaving: %d eRPM + %d EDT frames, %u eRPM samples counted, accel %d RPM/s, "
+           "link quality %u%%: %s\n\n", samples, edt_frames, telem.success_count, telem.rpm_accel,
+           telem.link_quality, failures ? "FAILED" : "ok");
+    return failures;
+}
+
+/**
+ * @brief Run the governor against a first-order motor model at 1kHz
+ *
+ * Motor: erpm -> gain * (throttle - 48) with a 50ms time constant. The
+ * load step drops the gain by 20% at 2s; from 4s to 5s the setpoint is
+ * above what full throttle reaches, then drops back.
+ *
+ * @return Number of failed checks
+ */
+static int check_governor(void) {
+    dshot_governor_config_t config;
+    dshot_governor_t gov;
+    double erpm = 0.0, gain = 50.0;
+    double err_settled = 0.0, err_load = 0.0;
+    int recover_ms = -1, slew_violations = 0, range_violations = 0;
+    uint16_t prev = DSHOT_THROTTLE_MIN;
+
+    dshot_governor_config_default(&config);
+    dshot_governor_reset(&gov, &config, DSHOT_THROTTLE_MIN);
+
+    for (int ms = 0; ms < 7000; ms++) {
+        uint32_t setpoint = (ms >= 4000 && ms < 5000) ? 150000 : 40000;
+
+        gov.setpoint = setpoint;
+        uint16_t throttle = dshot_governor_update(&gov, &config, (uint32_t)(erpm + 0.5));
+
+        if (throttle > prev + config.slew || throttle + config.slew < prev) {
+            slew_violations++;
+        }
+        if (throttle < config.out_min || throttle > config.out_max) {
+            range_violations++;
+        }
+        prev = throttle;
+
+        if (ms == 2000) {
+            gain = 40.0;
+        }
+        erpm += (gain * (throttle - DSHOT_THROTTLE_MIN) - erpm) * (1.0 / 50.0);
+
+        double err = (erpm - setpoint) / setpoint;
+        err = (err < 0) ? -err : err;
+        if (ms >= 1500 && ms < 2000 && err > err_settled) {
+            err_settled = err;
+        }
+        if (ms >= 3500 && ms < 4000 && err > err_load) {
+            err_load = err;
+        }
+        if (ms >= 5000 && recover_ms < 0 && err < 0.01) {
+            recover_ms = ms - 5000;
+        }
+    }
+
+    bool ok = err_settled < 0.01 && err_load < 0.01 && recover_ms >= 0 && recover_ms < 1000 &&
+              slew_violations == 0 && range_violations == 0;
+    printf("Governor: settled error %.2f%%, after load step %.2f%%, windup recovery %d ms, "
+           "slew/range violations %d/%d: %s\n\n",
+           100.0 * err_settled, 100.0 * err_load, recover_ms, slew_violations, range_violations,
+           ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Healthy motor model at 1kHz: 50 eRPM per throttle unit, 30ms
+ *        spin-up, 10ms braking, 1% noise and one outlier frame in 200
+ */
+static uint32_t health_motor(double *erpm, uint16_t throttle, double health) {
+    double target = (throttle >= DSHOT_THROTTLE_MIN) ? 50.0 * (throttle - DSHOT_THROTTLE_MIN) * health : 0.0;
+    double tau = (target < *erpm) ? 10.0 : 30.0;
+
+    *erpm += (target - *erpm) / tau;
+    if (rand() % 200 == 0) {
+        return (uint32_t)(rand() % 200000);
+    }
+    return (uint32_t)(*erpm * (0.99 + 0.0001 * (rand() % 201)));
+}
+
+/**
+ * @brief Throttle profile: start, steps, ramps and hard cuts, 8s period
+ */
+static uint16_t health_profile(int ms) {
+    int t = ms % 8000;
+
+    if (t < 1000) return 300;
+    if (t < 2000) return 900;
+    if (t < 3000) return 300 + (t - 2000);          /* Ramp up */
+    if (t < 4000) return 1300 - (t - 3000);         /* Ramp down */
+    if (t < 4500) return 1500;
+    if (t < 5000) return DSHOT_THROTTLE_MIN;        /* Hard cut */
+    if (t < 6000) return 700;
+    if (t < 7000) return 1100;
+    return 500;
+}
+
+/**
+ * @brief Check the detector for false alarms and detection latency
+ * @return Number of failed checks
+ */
+static int check_health(void) {
+    static const struct {
+        const char *name;
+        uint8_t flag;
+        double health_end;          /* Motor gain factor after the fault */
+        int ramp_ms;                /* Time to reach it */
+    } faults[] = {
+        { "stall",     DSHOT_HEALTH_STALL,    0.0, 5   },
+        { "collapse",  DSHOT_HEALTH_COLLAPSE, 0.3, 3   },
+        { "underspeed", DSHOT_HEALTH_DESYNC,  0.4, 200 },
+    };
+    dshot_health_config_t config;
+    dshot_health_t health;
+    int failures = 0;
+
+    dshot_health_config_default(&config);
+
+    /* 40s of normal operation: no flag may be raised */
+    double erpm = 0.0;
+    uint8_t flags = 0;
+    int learned = 0;
+    dshot_health_reset(&health, &config);
+    for (int ms = 0; ms < 40000; ms++) {
+        uint16_t throttle = health_profile(ms);
+        uint32_t measured = health_motor(&erpm, throttle, 1.0);
+        flags |= dshot_health_update(&health, &config, throttle, measured, true);
+    }
+    for (int b = 0; b < DSHOT_HEALTH_BINS; b++) {
+        learned += health.ratio[b] != 0;
+    }
+    printf("Health: 40s healthy profile, %d/%d bands learned, flags 0x%x: %s\n",
+           learned, DSHOT_HEALTH_BINS, flags, flags ? "FAILED" : "ok");
+    failures += flags != 0;
+
+    /* Faults injected at 800 throttle after the bands are learned */
+    for (unsigned f = 0; f < sizeof(faults) / sizeof(faults[0]); f++) {
+        dshot_health_t trained = health;
+        int detected = -1;
+
+        dshot_health_clear(&trained);
+        for (int ms = 0; ms < 2000 && detected < 0; ms++) {
+            double factor = 1.0;
+            if (ms >= 1000) {
+                int into = ms - 1000;
+                factor = (into >= faults[f].ramp_ms) ? faults[f].health_end :
+                         1.0 - (1.0 - faults[f].health_end) * into / faults[f].ramp_ms;
+            }
+            /* Fault changes the motor immediately, not through the spin-down lag */
+            uint32_t measured = health_motor(&erpm, 800, 1.0);
+            if (ms >= 1000) {
+                measured = (uint32_t)(measured * factor);
+            }
+            if ((dshot_health_update(&trained, &config, 800, measured, true) & faults[f].flag) && ms >= 1000) {
+                detected = ms - 1000;
+            }
+        }
+        bool ok = detected >= 0 && detected <= faults[f].ramp_ms + 50;
+        printf("Health: %-10s detected after %d ms: %s\n", faults[f].name, detected, ok ? "ok" : "FAILED");
+        failures += !ok;
+    }
+
+    printf("\n");
+    return failures;
+}
+
+/**
+ * @brief Run a governed motor through a health cut and clear
+ *
+ * Same per-frame order as the scheduler interrupt: faults latched with
+ * auto_cut send motor stop, everything else goes through the governor.
+ * The check_governor() motor seizes from 1s to 1.5s, the detector cuts
+ * it, and the fault is cleared at 2s. With the governor held through the
+ * cut, the first frame after the clear must be within one slew step of
+ * the fallback throttle and the output within the slew limit from there;
+ * the run with the governor left running through the cut (0 eRPM from
+ * the stopped motor) is printed for comparison.
+ *
+ * @return Number of failed checks
+ */
+static int check_governor_cut(void) {
+    const uint16_t fallback = 600;
+    dshot_governor_config_t config;
+    dshot_health_config_t health_config;
+    uint16_t restart[2] = { 0, 0 };
+    int failures = 0;
+
+    dshot_governor_config_default(&config);
+    dshot_health_config_default(&health_config);
+    health_config.auto_cut = true;
+
+    for (int held = 1; held >= 0; held--) {
+        dshot_governor_t gov;
+        dshot_health_t health;
+        bool engaged = false;
+        double erpm = 0.0;
+        int cut_ms = -1, slew_violations = 0;
+        uint8_t refault = 0;
+        uint16_t prev = 0;
+
+        dshot_health_reset(&health, &health_config);
+        for (int ms = 0; ms < 3000; ms++) {
+            double gain = (ms >= 1000 && ms < 1500) ? 0.0 : 50.0;
+
+            if (ms == 2000) {
+                dshot_health_clear(&health);
+            }
+            bool cut = health.faults && health_config.auto_cut;
+
+            uint16_t throttle;
+            if (cut && held) {
+                engaged = false;
+                throttle = DSHOT_CMD_MOTOR_STOP;
+            } else {
+                if (!engaged) {
+                    dshot_governor_reset(&gov, &config, fallback);
+                    engaged = true;
+                }
+                gov.setpoint = 40000;
+                throttle = dshot_governor_update(&gov, &config, (uint32_t)(erpm + 0.5));
+                if (cut) {
+                    throttle = DSHOT_CMD_MOTOR_STOP;
+                }
+            }
+
+            if (cut && cut_ms < 0) {
+                cut_ms = ms;
+            }
+            if (ms == 2000) {
+                restart[held] = throttle;
+            } else if (ms > 2000 && (throttle > prev + config.slew || throttle + config.slew < prev)) {
+                slew_violations++;
+            }
+            prev = throttle;
+
+            uint8_t flags = dshot_health_update(&health, &health_config, throttle, (uint32_t)(erpm + 0.5), true);
+            if (ms >= 2000) {
+                refault |= flags;
+            }
+            double drive = (throttle >= DSHOT_THROTTLE_MIN) ? throttle - DSHOT_THROTTLE_MIN : 0.0;
+            erpm += (gain * drive - erpm) * (1.0 / 50.0);
+        }
+
+        if (held) {
+            bool ok = cut_ms >= 1000 && cut_ms < 2000 && restart[1] <= fallback + config.slew &&
+                      restart[1] + config.slew >= fallback &&
+                      slew_violations == 0 && refault == 0;
+            printf("Governor cut: cut at %d ms, restart throttle %u (fallback %u), "
+                   "slew violations %d, flags after clear 0x%x: %s\n",
+                   cut_ms, restart[1], fallback, slew_violations, refault, ok ? "ok" : "FAILED");
+            failures += !ok;
+        }
+    }
+    printf("Governor cut: restart throttle %u with the governor running through the cut\n\n", restart[0]);
+
+    return failures;
+}
+
+/**
+ * @brief Frame error rate with a fixed and an adaptive bit period
+ *
+ * The sweep reaches past the drift a fixed bit period tolerates (a 3-bit
+ * run plus jitter rounds wrong from about 13%), so the fixed decoder
+ * fails at the outer cases; the adaptive one must do strictly better
+ * wherever the fixed one loses frames, and never worse.
+ *
+ * @return Number of failed drift cases
+ */
+static int bench_drift(uint16_t speed) {
+    static const int drift_pct_x10[] = { -180, -150, -120, -90, -60, -30, 0, 30, 60, 90, 120, 150, 180 };
+    dshot_timing_t timing;
+    dshot_edge_table_t table;
+    int failures = 0, fixed_total = 0, adaptive_total = 0;
+
+    dshot_timing_init(&timing, 168000000UL, speed);
+    dshot_edge_table_init(&table, timing.telem_bit);
+
+    printf("\nDShot%u frame errors vs ESC clock drift (%d frames each)\n", speed, BENCH_DRIFT_FRAMES);
+    printf("%-8s %10s %10s %12s\n", "drift", "fixed", "adaptive", "estimate");
+
+    for (unsigned d = 0; d < sizeof(drift_pct_x10) / sizeof(drift_pct_x10[0]); d++) {
+        uint32_t period_q8 = (uint32_t)timing.telem_bit * 256 * (1000 + drift_pct_x10[d]) / 1000;
+        uint32_t scale = DSHOT_RX_SCALE_ONE;
+        int fixed_err = 0, adaptive_err = 0;
+
+        for (int i = 0; i < BENCH_DRIFT_FRAMES; i++) {
+            capture_t c;
+            uint16_t value = random_erpm_value();
+
+            make_capture(&c, make_response(value), period_q8);
+
+            if (!decode_ok(&table, &c, DSHOT_RX_SCALE_ONE, value)) {
+                fixed_err++;
+            }
+            if (decode_ok(&table, &c, scale, value)) {
+                scale = dshot_rx_scale_update(&table, c.edges, c.count, scale);
+            } else {
+                adaptive_err++;
+            }
+        }
+
+        bool ok = fixed_err ? adaptive_err < fixed_err : adaptive_err == 0;
+        printf("%+6.1f%% %9.2f%% %9.2f%% %11.4f%s\n", drift_pct_x10[d] / 10.0,
+               100.0 * fixed_err / BENCH_DRIFT_FRAMES, 100.0 * adaptive_err / BENCH_DRIFT_FRAMES,
+               (double)scale / DSHOT_RX_SCALE_ONE, ok ? "" : "  FAILED");
+        failures += !ok;
+        fixed_total += fixed_err;
+        adaptive_total += adaptive_err;
+    }
+
+    /* A sweep the fixed decoder survives proves nothing */
+    if (fixed_total == 0) {
+        printf("fixed bit period never failed: sweep too narrow\n");
+        failures++;
+    }
+    printf("all drift cases: fixed %d, adaptive %d frame errors: %s\n",
+           fixed_total, adaptive_total, failures ? "FAILED" : "ok");
+    return failures;
+}
+
+int main(void) {
+    static const uint16_t speeds[] = { 150, 300, 600, 1200 };
+    int failures = 0;
+
+    srand(12345);
+
+    printf("DShot telemetry edge decoder benchmark\n");
+    failures += check_decode();
+    failures += check_erpm();
+    failures += check_filter();
+    failures += check_motion();
+    failures += check_edt();
+    failures += check_governor();
+    failures += check_health();
+    failures += check_governor_cut();
+
+    printf("%d captures x %d passes per decoder, jitter +/-%d%% of a bit\n\n",
+           BENCH_CAPTURES, BENCH_PASSES, BENCH_JITTER_PCT);
+    printf("%-10s %-10s %10s %12s %8s\n", "speed", "decoder", "ns/frame", "cycles/frame", "speedup");
+
+    for (unsigned s = 0; s < sizeof(speeds) / sizeof(speeds[0]); s++) {
+        dshot_timing_t timing;
+        dshot_edge_table_t table;
+
+        dshot_timing_init(&timing, 168000000UL, speeds[s]);
+        dshot_edge_table_init(&table, timing.telem_bit);
+
+        for (int i = 0; i < BENCH_CAPTURES; i++) {
+            make_capture(&captures[i], make_response(random_erpm_value()), (uint32_t)timing.telem_bit << 8);
+        }
+
+        /* Both decoders must agree on every capture */
+        for (int i = 0; i < BENCH_CAPTURES; i++) {
+            uint32_t ref_bits, tab_bits;
+            uint8_t ref_n = dshot_edges_to_bits(captures[i].edges, captures[i].count,
+                                                timing.telem_bit, &ref_bits);
+            uint8_t tab_n = dshot_edges_to_bits_table(&table, captures[i].edges,
+                                                      captures[i].count, DSHOT_RX_SCALE_ONE, &tab_bits);
+            if (ref_n != tab_n || ref_bits != tab_bits) {
+                if (failures < 10) {
+                    printf("MISMATCH DShot%u capture %d: ref %u/%06x table %u/%06x\n",
+                           speeds[s], i, ref_n, ref_bits, tab_n, tab_bits);
+                }
+                failures++;
+            }
+        }
+
+        volatile uint32_t sink = 0;
+        uint64_t total = (uint64_t)BENCH_CAPTURES * BENCH_PASSES;
+        uint64_t t0, c0, ref_ns, ref_cyc, tab_ns, tab_cyc;
+
+        t0 = now_ns();
+        c0 = now_cycles();
+        for (int p = 0; p < BENCH_PASSES; p++) {
+            for (int i = 0; i < BENCH_CAPTURES; i++) {
+                uint32_t bits;
+                sink += dshot_edges_to_bits(captures[i].edges, captures[i].count,
+                                            timing.telem_bit, &bits);
+                sink ^= bits;
+            }
+        }
+        ref_cyc = now_cycles() - c0;
+        ref_ns = now_ns() - t0;
+
+        t0 = now_ns();
+        c0 = now_cycles();
+        for (int p = 0; p < BENCH_PASSES; p++) {
+            for (int i = 0; i < BENCH_CAPTURES; i++) {
+                uint32_t bits;
+                sink += dshot_edges_to_bits_table(&table, captures[i].edges,
+                                                  captures[i].count, DSHOT_RX_SCALE_ONE, &bits);
+                sink ^= bits;
+            }
+        }
+        tab_cyc = now_cycles() - c0;
+        tab_ns = now_ns() - t0;
+
+        printf("DShot%-5u %-10s %10.2f %12.1f %8s\n", speeds[s], "loop",
+               (double)ref_ns / total, (double)ref_cyc / total, "");
+        printf("DShot%-5u %-10s %10.2f %12.1f %7.2fx\n", speeds[s], "table",
+               (double)tab_ns / total, (double)tab_cyc / total,
+               tab_ns ? (double)ref_ns / tab_ns : 0.0);
+        (void)sink;
+    }
+
+    failures += bench_drift(600);
+
+#ifndef BENCH_HAVE_TSC
+    printf("\n(cycle counter not available on this host; cycles/frame reads 0)\n");
+#else
+    printf("\n(cycles are TSC reference cycles)\n");
+#endif
+
+    if (failures) {
+        printf("\n%d failures\n", failures);
+        return 1;
+    }
+    printf("\nAll captures decoded identically, all responses verified\n");
+    return 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file dshot_replay.c
+ * @brief Replay logged telemetry captures through the host decoder
+ *
+ * Reads files holding one or more binary capture dumps (see
+ * dshot_capture.h), e.g. a raw serial log of the 'd' command, and runs
+ * every record through the same decode path as the firmware: the
+ * run-length table for the recorded bit period, the recorded clock
+ * estimate, idle padding and GCR/CRC checks. Each record is printed with
+ * its recorded and replayed result, so decoder changes can be checked
+ * against field captures.
+ *
+ * Build with `make replay`, then run build/host/dshot_replay <dump>...
+ * Use -v to also print the edge deltas of every record.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dshot_capture.h"
+
+static const char *result_names[DSHOT_TELEM_RESULT_COUNT] = {
+    "ok", "timeout", "edges", "bits", "gcr", "crc", "edt",
+};
+
+static const char *result_name(uint8_t result) {
+    return (result < DSHOT_TELEM_RESULT_COUNT) ? result_names[result] : "?";
+}
+
+static uint32_t get_le(const uint8_t *p, int bytes) {
+    uint32_t value = 0;
+
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+/**
+ * @brief Decode one record the way the firmware does
+ */
+static dshot_telem_result_t replay(const dshot_capture_record_t *r, dshot_telemetry_t *telem) {
+    dshot_edge_table_t table;
+    uint32_t bits;
+
+    if (r->edge_count == 0) {
+        return DSHOT_TELEM_ERR_TIMEOUT;
+    }
+    if (r->edge_count < DSHOT_TELEM_MIN_EDGES) {
+        return DSHOT_TELEM_ERR_EDGES;
+    }
+
+    dshot_edge_table_init(&table, r->bit_period);
+    uint8_t n = dshot_edges_to_bits_table(&table, r->edges, r->edge_count, r->rx_scale, &bits);
+    if (n < DSHOT_TELEM_MIN_BITS) {
+        return DSHOT_TELEM_ERR_BITS;
+    }
+    bits <<= DSHOT_TELEM_FRAME_BITS - n;
+
+    return dshot_decode_gcr_frame(bits, telem);
+}
+
+/**
+ * @brief Parse one record at p (at most len bytes)
+ * @return Bytes consumed, 0 if truncated or the check byte does not match
+ */
+static size_t parse_record(const uint8_t *p, size_t len, dshot_capture_record_t *r) {
+    const size_t fixed = 3 + 2 + 4 + 4;
+    uint8_t check = 0;
+
+    if (len < fixed + 1) {
+        return 0;
+    }
+    r->motor = p[0];
+    r->result = p[1];
+    r->edge_count = p[2];
+    r->bit_period = get_le(p + 3, 2);
+    r->rx_scale = get_le(p + 5, 4);
+    r->seq = get_le(p + 9, 4);
+
+    size_t size = fixed + 2 * (size_t)r->edge_count + 1;
+    if (r->edge_count > DSHOT_CAPTURE_MAX_EDGES || len < size) {
+        return 0;
+    }
+    for (int i = 0; i < r->edge_count; i++) {
+        r->edges[i] = get_le(p + fixed + 2 * i, 2);
+    }
+    for (size_t i = 0; i < size - 1; i++) {
+        check ^= p[i];
+    }
+    return (check == p[size - 1]) ? size : 0;
+}
+
+int main(int argc, char **argv) {
+    int verbose = 0;
+    int records = 0, bad = 0, changed = 0, recovered = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s [-v] dump...\n", argv[0]);
+        return 2;
+    }
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-v") == 0) {
+            verbose = 1;
+            continue;
+        }
+
+        FILE *f = fopen(argv[a], "rb");
+        if (!f) {
+            perror(argv[a]);
+            return 2;
+        }
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        uint8_t *data = malloc(size > 0 ? size : 1);
+        if (!data || fread(data, 1, size, f) != (size_t)size) {
+            fprintf(stderr, "%s: read error\n", argv[a]);
+            return 2;
+        }
+        fclose(f);
+
+        /* Dumps may be embedded in a serial log: scan for the magic */
+        for (long pos = 0; pos + DSHOT_CAPTURE_MAGIC_LEN + 1 <= size; pos++) {
+            if (memcmp(data + pos, DSHOT_CAPTURE_MAGIC, DSHOT_CAPTURE_MAGIC_LEN) != 0) {
+                continue;
+            }
+            pos += DSHOT_CAPTURE_MAGIC_LEN;
+            uint8_t count = data[pos++];
+
+            for (uint8_t n = 0; n < count; n++) {
+                dshot_capture_record_t r;
+                dshot_telemetry_t telem;
+                size_t used = parse_record(data + pos, size - pos, &r);
+
+                if (!used) {
+                    fprintf(stderr, "%s: bad record at offset %ld\n", argv[a], pos);
+                    bad++;
+                    break;
+                }
+                pos += used;
+                records++;
+
+                memset(&telem, 0, sizeof(telem));
+                dshot_telem_result_t result = replay(&r, &telem);
+
+                printf("#%-8u motor %u  %2u edges  period %u  scale %.4f  logged %-7s replay %-7s",
+                       r.seq, r.motor, r.edge_count, r.bit_period,
+                       (double)r.rx_scale / DSHOT_RX_SCALE_ONE,
+                       result_name(r.result), result_name(result));
+                if (result == DSHOT_TELEM_OK) {
+                    printf("  %u us / %u eRPM", telem.period_us, telem.erpm);
+                } else if (result == DSHOT_TELEM_EDT) {
+                    printf("  EDT types 0x%02x", telem.edt.received);
+                }
+                printf("\n");
+
+                if (verbose && r.edge_count > 1) {
+                    printf("          deltas:");
+                    for (int i = 1; i < r.edge_count; i++) {
+                        printf(" %u", (uint16_t)(r.edges[i] - r.edges[i - 1]));
+                    }
+                    printf("\n");
+                }
+
+                if (result != r.result) {
+                    changed++;
+                    if (DSHOT_TELEM_VALID(result)) {
+                        recovered++;
+                    }
+                }
+            }
+            pos--;  /* Loop increment */
+        }
+        free(data);
+    }
+
+    printf("\n%d records, %d with a different result (%d now decode), %d unreadable\n",
+           records, changed, recovered, bad);
+    return bad ? 1 : 0;
+}